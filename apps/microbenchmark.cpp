@@ -4,17 +4,22 @@
 #include <boost/program_options.hpp>
 #include <boost/thread/barrier.hpp>
 #include <chrono>
+#include <concepts>
 #include <cstdint>
 #include <iostream>
 #include <mutex>
 #include <optional>
 #include <thread>
 
+#include "splittable/mrv/mrv_array.hpp"
+#include "splittable/mrv/mrv_numa.hpp"
 #include "splittable/mrv/mrv_flex_vector.hpp"
 #include "splittable/pr/pr_array.hpp"
 #include "splittable/single/single.hpp"
+#include "splittable/utils/numa.hpp"
 #include "splittable/utils/random.hpp"
 
+using std::chrono::microseconds;
 using std::chrono::nanoseconds;
 using std::chrono::seconds;
 using std::chrono::steady_clock;
@@ -22,6 +27,7 @@ using std::chrono::steady_clock;
 using namespace std::chrono_literals;
 
 const seconds warmup(5);
+const auto grow_sample_interval = 10ms;
 
 struct result_t {
   uint writes;
@@ -30,15 +36,24 @@ struct result_t {
   nanoseconds avg_adjust_interval;
   nanoseconds avg_balance_interval;
   nanoseconds avg_phase_interval;
+  // only filled with `--grow_report`
+  uint grows;
+  double avg_grow_reaction_ms;
 };
 
 struct options_t {
   std::string benchmark;
+  std::string value_type;
   size_t num_workers;
   size_t read_percentage;
+  size_t inconsistent_read_percentage;
   seconds duration;
   size_t time_padding;
   size_t scale;
+  bool coalesce;
+  bool add_heavy;
+  bool read_groups;
+  bool grow_report;
 };
 
 double waste_time(size_t iterations) {
@@ -51,8 +66,81 @@ double waste_time(size_t iterations) {
   return value;
 }
 
+template <splittable::splittable_type S>
+void write(S& value, WSTM::WAtomic& at, const options_t& options) {
+  using value_t = typename S::value_type;
+
+  auto rare = splittable::utils::random_index(0, options.scale) == 0;
+
+  if (options.add_heavy) {
+    // mostly unit additions (restocks, refunds), with a subtraction of the
+    // same size once in a while so the value does not grow too fast
+    if (rare) {
+      value.sub(at, 1);
+    } else {
+      value.add(at, 1);
+    }
+  } else if (rare) {
+    value.add(at, static_cast<value_t>(options.scale));
+  } else {
+    value.sub(at, 1);
+  }
+}
+
+// samples the abort rate every `grow_sample_interval` and, each time the
+// object grows, measures how long it takes for the rate to get back under the
+// one that made the manager grow it
 template <typename S>
+void monitor_grows(S& value, const std::atomic_bool& running, uint& grows,
+                   double& avg_reaction_ms) {
+  using splittable::mrv::MAX_ABORT_RATE;
+
+  auto last = splittable::splittable::get_global_stats();
+  auto last_size = value.chunk_count();
+  std::optional<steady_clock::time_point> grown_at;
+  nanoseconds total_reaction(0);
+  uint reactions = 0;
+
+  while (running.load()) {
+    std::this_thread::sleep_for(grow_sample_interval);
+    auto now = steady_clock::now();
+    auto stats = splittable::splittable::get_global_stats();
+    auto size = value.chunk_count();
+
+    // a grow before the previous one settled restarts the measurement
+    if (size > last_size) {
+      ++grows;
+      grown_at = now;
+    }
+    last_size = size;
+
+    // the stats go back when they are reset at the end of the warmup
+    if (stats.aborts < last.aborts || stats.commits < last.commits) {
+      last = stats;
+      continue;
+    }
+
+    auto aborts = stats.aborts - last.aborts;
+    auto commits = stats.commits - last.commits;
+    last = stats;
+
+    if (grown_at && aborts + commits > 0 &&
+        static_cast<double>(aborts) / (aborts + commits) <= MAX_ABORT_RATE) {
+      total_reaction += now - *grown_at;
+      ++reactions;
+      grown_at.reset();
+    }
+  }
+
+  if (reactions > 0) {
+    avg_reaction_ms = (total_reaction / reactions).count() / 1000000.0;
+  }
+}
+
+template <splittable::splittable_type S>
 result_t run(options_t options) {
+  using value_t = typename S::value_type;
+
   auto total_reads = std::atomic_uint(0);
   auto total_writes = std::atomic_uint(0);
 
@@ -68,10 +156,39 @@ result_t run(options_t options) {
       S::thread_init();
 
       double val{};
-      uint val2{};
+      value_t val2{};
       size_t reads = 0;
       size_t writes = 0;
 
+      auto execute = [&](size_t random_pick) {
+        auto is_read = random_pick <= options.read_percentage;
+
+        // this share of the reads is done outside of any transaction, so it
+        // never conflicts with the writers
+        if (is_read && options.inconsistent_read_percentage > 0 &&
+            splittable::utils::random_index(1, 100) <=
+                options.inconsistent_read_percentage) {
+          WSTM::Inconsistently([&](WSTM::WInconsistent& inc) {
+            val = waste_time(options.time_padding);
+            val2 = value->inconsistent_read(inc);
+            val = waste_time(options.time_padding);
+          });
+          return;
+        }
+
+        WSTM::Atomically([&](WSTM::WAtomic& at) {
+          val = waste_time(options.time_padding);
+
+          if (is_read) {
+            val2 = value->read(at);
+          } else {
+            write(*value, at, options);
+          }
+
+          val = waste_time(options.time_padding);
+        });
+      };
+
       bar.wait();
 
       auto now = steady_clock::now;
@@ -81,19 +198,7 @@ result_t run(options_t options) {
         auto random_pick = splittable::utils::random_index(1, 100);
 
         try {
-          WSTM::Atomically([&](WSTM::WAtomic& at) {
-            val = waste_time(options.time_padding);
-
-            if (random_pick <= options.read_percentage) {
-              val2 = value->read(at);
-            } else if (splittable::utils::random_index(0, options.scale) == 0) {
-              value->add(at, options.scale);
-            } else {
-              value->sub(at, 1);
-            }
-
-            val = waste_time(options.time_padding);
-          });
+          execute(random_pick);
         } catch (...) {
         }
       }
@@ -105,19 +210,7 @@ result_t run(options_t options) {
         auto random_pick = splittable::utils::random_index(1, 100);
 
         try {
-          WSTM::Atomically([&](WSTM::WAtomic& at) {
-            val = waste_time(options.time_padding);
-
-            if (random_pick <= options.read_percentage) {
-              val2 = value->read(at);
-            } else if (splittable::utils::random_index(0, options.scale) == 0) {
-              value->add(at, options.scale);
-            } else {
-              value->sub(at, 1);
-            }
-
-            val = waste_time(options.time_padding);
-          });
+          execute(random_pick);
 
           if (random_pick <= options.read_percentage) {
             reads++;
@@ -140,10 +233,29 @@ result_t run(options_t options) {
 
   bar.wait();
 
+  std::atomic_bool monitoring(true);
+  uint grows = 0;
+  double avg_grow_reaction_ms = 0;
+  std::thread monitor;
+
+  if constexpr (requires { value->chunk_count(); }) {
+    if (options.grow_report) {
+      monitor = std::thread([&]() {
+        std::this_thread::sleep_for(warmup);
+        monitor_grows(*value, monitoring, grows, avg_grow_reaction_ms);
+      });
+    }
+  }
+
   for (size_t i = 0; i < options.num_workers; i++) {
     threads[i].join();
   }
 
+  monitoring.store(false);
+  if (monitor.joinable()) {
+    monitor.join();
+  }
+
   auto stats = splittable::splittable::get_global_stats();
   auto abort_rate =
       static_cast<double>(stats.aborts) / (stats.aborts + stats.commits);
@@ -153,7 +265,101 @@ result_t run(options_t options) {
           .abort_rate = abort_rate,
           .avg_adjust_interval = value->get_avg_adjust_interval(),
           .avg_balance_interval = value->get_avg_balance_interval(),
-          .avg_phase_interval = value->get_avg_phase_interval()};
+          .avg_phase_interval = value->get_avg_phase_interval(),
+          .grows = grows,
+          .avg_grow_reaction_ms = avg_grow_reaction_ms};
+}
+
+// sets the balance strategy of an MRV type from the command line; returns
+// false if it is not valid
+template <typename M>
+bool configure_mrv(const boost::program_options::variables_map& vm,
+                   std::string& balance) {
+  if (!vm.count("mrv_balance")) {
+    std::cerr << "need to specify a MRV balance (-m <balance-type>)\n";
+    return false;
+  }
+
+  balance = vm["mrv_balance"].as<std::string>();
+  using splittable::mrv::balance_strategy_t;
+  if (balance == "none") {
+    M::set_balance_strategy(balance_strategy_t::none);
+  } else if (balance == "random") {
+    M::set_balance_strategy(balance_strategy_t::random);
+  } else if (balance == "minmax") {
+    M::set_balance_strategy(balance_strategy_t::minmax);
+  } else if (balance == "all") {
+    M::set_balance_strategy(balance_strategy_t::all);
+  } else {
+    std::cerr << "could not find a balance type with name \"" << balance
+              << "\"; try \"none\", \"random\", \"minmax\", \"all\"\n";
+    return false;
+  }
+
+  return true;
+}
+
+template <std::integral V>
+std::optional<result_t> run_benchmark(
+    options_t options, const boost::program_options::variables_map& vm,
+    std::string& balance, std::string& add, std::string& chunk) {
+  if (options.benchmark == "single") {
+    using splittable_t = splittable::single::single<V>;
+    return run<splittable_t>(options);
+  } else if (options.benchmark == "mrv-flex-vector") {
+    using splittable_t = splittable::mrv::mrv_flex_vector<V>;
+    if (!configure_mrv<splittable_t>(vm, balance)) {
+      return std::nullopt;
+    }
+
+    chunk = vm["mrv_chunk"].as<std::string>();
+    using splittable::mrv::chunk_selection_t;
+    if (chunk == "random") {
+      splittable_t::set_chunk_selection(chunk_selection_t::random);
+    } else if (chunk == "cpu") {
+      splittable_t::set_chunk_selection(chunk_selection_t::cpu);
+    } else {
+      std::cerr << "could not find a chunk selection with name \"" << chunk
+                << "\"; try \"random\", \"cpu\"\n";
+      return std::nullopt;
+    }
+
+    add = vm["mrv_add"].as<std::string>();
+    using splittable::mrv::add_strategy_t;
+    if (add == "direct") {
+      splittable_t::set_add_strategy(add_strategy_t::direct);
+    } else if (add == "commutative") {
+      splittable_t::set_add_strategy(add_strategy_t::commutative);
+    } else {
+      std::cerr << "could not find an add strategy with name \"" << add
+                << "\"; try \"direct\", \"commutative\"\n";
+      return std::nullopt;
+    }
+
+    splittable_t::set_read_aggregation(options.read_groups);
+
+    return run<splittable_t>(options);
+  } else if (options.benchmark == "mrv-array") {
+    using splittable_t = splittable::mrv::mrv_array<V>;
+    if (!configure_mrv<splittable_t>(vm, balance)) {
+      return std::nullopt;
+    }
+    return run<splittable_t>(options);
+  } else if (options.benchmark == "mrv-numa") {
+    using splittable_t = splittable::mrv::mrv_numa<V>;
+    if (!configure_mrv<splittable_t>(vm, balance)) {
+      return std::nullopt;
+    }
+    return run<splittable_t>(options);
+  } else if (options.benchmark == "pr-array") {
+    using splittable_t = splittable::pr::pr_array<V>;
+    return run<splittable_t>(options);
+  }
+
+  std::cerr << "could not find a benchmark with name \"" << options.benchmark
+            << "\"; try \"single\", \"mrv-flex-vector\", \"mrv-array\", "
+               "\"mrv-numa\", \"pr-array\"\n";
+  return std::nullopt;
 }
 
 int main(int argc, char const* argv[]) {
@@ -174,6 +380,9 @@ int main(int argc, char const* argv[]) {
     ("read_percentage,r", 
       po::value<size_t>()->required(),  
       "set percentage of read operations")
+    ("inconsistent_read_percentage,i", 
+      po::value<size_t>()->default_value(0),  
+      "set percentage of the reads done with `Inconsistently`")
     ("duration,d", 
       po::value<size_t>()->required(),  
       "set benchmark duration (in seconds)")
@@ -185,7 +394,41 @@ int main(int argc, char const* argv[]) {
       "set scale for writes (how big should adds be per sub)")
     ("mrv_balance,m", 
       po::value<std::string>(), 
-      "set MRV balance type (required for MRV benchmarks)");
+      "set MRV balance type (required for MRV benchmarks)")
+    ("mrv_add,a", 
+      po::value<std::string>()->default_value("direct"), 
+      "set MRV add strategy (direct, commutative; mrv-flex-vector only)")
+    ("mrv_chunk,k", 
+      po::value<std::string>()->default_value("random"), 
+      "set MRV chunk selection (random, cpu; cpu is mrv-flex-vector only)")
+    ("write_profile,W", 
+      po::value<std::string>()->default_value("default"), 
+      "set write mix (default: one add per `scale` subs; add-heavy: one sub "
+      "per `scale` adds)")
+    ("value_type,v", 
+      po::value<std::string>()->default_value("uint32"), 
+      "set counter type of the splittable (uint32, uint64, int64)")
+    ("coalesce,c", 
+      po::bool_switch(), 
+      "buffer additions per transaction and apply them at commit")
+    ("mrv_read_groups,g", 
+      po::bool_switch(), 
+      "keep partial sums of the MRV chunks for reads (mrv-flex-vector only)")
+    ("manager_threads,T", 
+      po::value<size_t>(), 
+      "set number of threads the managers adjust the objects with (0 runs "
+      "them on the manager thread)")
+    ("manager_cpus,C", 
+      po::value<std::string>()->default_value(""), 
+      "set CPUs the manager threads are pinned to, e.g. \"0-1,8\"")
+    ("manager_budget,B", 
+      po::value<size_t>()->default_value(0), 
+      "set CPU time each manager pass may use (in microseconds, 0 for no "
+      "limit)")
+    ("grow_report,G", 
+      po::bool_switch(), 
+      "add the number of grows and how long the abort rate took to drop "
+      "after them to the output (mrv-flex-vector only)");
   // clang-format on
 
   po::variables_map vm;
@@ -193,48 +436,61 @@ int main(int argc, char const* argv[]) {
   po::notify(vm);
 
   options.benchmark = vm["benchmark"].as<std::string>();
+  options.value_type = vm["value_type"].as<std::string>();
   options.num_workers = vm["num_workers"].as<size_t>();
   options.read_percentage = vm["read_percentage"].as<size_t>();
+  options.inconsistent_read_percentage =
+      vm["inconsistent_read_percentage"].as<size_t>();
   options.duration = seconds{vm["duration"].as<size_t>()};
   options.time_padding = vm["time_padding"].as<size_t>();
   options.scale = vm["scale"].as<size_t>();
+  options.coalesce = vm["coalesce"].as<bool>();
+  options.read_groups = vm["mrv_read_groups"].as<bool>();
+  options.grow_report = vm["grow_report"].as<bool>();
   std::string balance("");
+  std::string add("direct");
+  std::string chunk("random");
 
-  result_t result;
-  if (options.benchmark == "single") {
-    using splittable_t = splittable::single::single;
-    result = run<splittable_t>(options);
-  } else if (options.benchmark == "mrv-flex-vector") {
-    using splittable_t = splittable::mrv::mrv_flex_vector;
+  auto write_profile = vm["write_profile"].as<std::string>();
+  if (write_profile != "default" && write_profile != "add-heavy") {
+    std::cerr << "could not find a write profile with name \"" << write_profile
+              << "\"; try \"default\", \"add-heavy\"\n";
+    return 1;
+  }
+  options.add_heavy = write_profile == "add-heavy";
 
-    if (!vm.count("mrv_balance")) {
-      std::cerr << "need to specify a MRV balance (-m <balance-type>)\n";
-      return 1;
-    }
+  splittable::splittable::set_delta_coalescing(options.coalesce);
 
-    balance = vm["mrv_balance"].as<std::string>();
-    using splittable::mrv::balance_strategy_t;
-    if (balance == "none") {
-      splittable_t::set_balance_strategy(balance_strategy_t::none);
-    } else if (balance == "random") {
-      splittable_t::set_balance_strategy(balance_strategy_t::random);
-    } else if (balance == "minmax") {
-      splittable_t::set_balance_strategy(balance_strategy_t::minmax);
-    } else if (balance == "all") {
-      splittable_t::set_balance_strategy(balance_strategy_t::all);
-    } else {
-      std::cerr << "could not find a balance type with name \"" << balance
-                << "\"; try \"none\", \"random\", \"minmax\", \"all\"\n";
-      return 1;
-    }
+  splittable::utils::worker_pool_options pool;
+  if (vm.count("manager_threads")) {
+    pool.threads = vm["manager_threads"].as<size_t>();
+  }
+  pool.cpus =
+      splittable::utils::parse_cpu_list(vm["manager_cpus"].as<std::string>());
+  pool.cpu_budget = microseconds{vm["manager_budget"].as<size_t>()};
+
+  // only the manager of the type being run is created
+  if (options.benchmark.starts_with("mrv")) {
+    splittable::mrv::manager::get_instance().configure_pool(pool);
+  } else if (options.benchmark.starts_with("pr")) {
+    splittable::pr::manager::get_instance().configure_pool(pool);
+  }
 
-    result = run<splittable_t>(options);
-  } else if (options.benchmark == "pr-array") {
-    using splittable_t = splittable::pr::pr_array;
-    result = run<splittable_t>(options);
+  std::optional<result_t> result;
+  if (options.value_type == "uint32") {
+    result = run_benchmark<uint32_t>(options, vm, balance, add, chunk);
+  } else if (options.value_type == "uint64") {
+    result = run_benchmark<uint64_t>(options, vm, balance, add, chunk);
+  } else if (options.value_type == "int64") {
+    result = run_benchmark<int64_t>(options, vm, balance, add, chunk);
   } else {
-    std::cerr << "could not find a benchmark with name \"" << options.benchmark
-              << "\"; try \"single\", \"mrv-flex-vector\", \"pr-array\"\n";
+    std::cerr << "could not find a value type with name \""
+              << options.value_type
+              << "\"; try \"uint32\", \"uint64\", \"int64\"\n";
+    return 1;
+  }
+
+  if (!result) {
     return 1;
   }
 
@@ -242,20 +498,67 @@ int main(int argc, char const* argv[]) {
     balance = ".balance-" + balance;
   }
 
+  // the default keeps the same name as before, so old results still match
+  std::string value_type("");
+  if (options.value_type != "uint32") {
+    value_type = ".value-" + options.value_type;
+  }
+
+  std::string coalesce("");
+  if (options.coalesce) {
+    coalesce = ".coalesce";
+  }
+
+  if (add != "direct") {
+    add = ".add-" + add;
+  } else {
+    add = "";
+  }
+
+  if (chunk != "random") {
+    chunk = ".chunk-" + chunk;
+  } else {
+    chunk = "";
+  }
+
+  std::string read_groups("");
+  if (options.read_groups) {
+    read_groups = ".read-groups";
+  }
+
+  std::string profile("");
+  if (options.add_heavy) {
+    profile = ".add-heavy";
+  }
+
+  std::string inconsistent("");
+  if (options.inconsistent_read_percentage > 0) {
+    inconsistent = ".inconsistent-" +
+                   std::to_string(options.inconsistent_read_percentage);
+  }
+
   // CSV: benchmark, workers, execution time, padding, read percentage, writes,
   // reads, write throughput (ops/s), read throughput (ops/s), abort rate, avg
-  // adjust interval, avg balance interval, avg phase interval
-  std::cout << options.benchmark << balance << "," << options.num_workers << ","
-            << options.duration.count() << "," << options.time_padding << ","
-            << options.read_percentage << "," << result.writes << ","
-            << result.reads << ","
-            << static_cast<double>(result.writes) / options.duration.count()
+  // adjust interval, avg balance interval, avg phase interval[, grows, avg grow
+  // reaction]
+  std::cout << options.benchmark << balance << add << chunk << value_type
+            << coalesce << read_groups << profile << inconsistent << ","
+            << options.num_workers << "," << options.duration.count() << ","
+            << options.time_padding << "," << options.read_percentage << ","
+            << result->writes << "," << result->reads << ","
+            << static_cast<double>(result->writes) / options.duration.count()
             << ","
-            << static_cast<double>(result.reads) / options.duration.count()
-            << "," << result.abort_rate << ","
-            << result.avg_adjust_interval.count() / 1000000.0 << ","
-            << result.avg_balance_interval.count() / 1000000.0 << ","
-            << result.avg_phase_interval.count() / 1000000.0 << "\n";
+            << static_cast<double>(result->reads) / options.duration.count()
+            << "," << result->abort_rate << ","
+            << result->avg_adjust_interval.count() / 1000000.0 << ","
+            << result->avg_balance_interval.count() / 1000000.0 << ","
+            << result->avg_phase_interval.count() / 1000000.0;
+
+  if (options.grow_report) {
+    std::cout << "," << result->grows << "," << result->avg_grow_reaction_ms;
+  }
+
+  std::cout << "\n";
 
   // return 0;
   quick_exit(0);
@@ -0,0 +1,246 @@
+#include <wstm/stm.h>
+
+#include <atomic>
+#include <boost/program_options.hpp>
+#include <boost/thread/barrier.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <optional>
+#include <thread>
+
+#include "splittable/mrv/mrv_flex_vector.hpp"
+#include "splittable/pr/pr_array.hpp"
+#include "splittable/single/single.hpp"
+#include "splittable/utils/random.hpp"
+
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+using namespace std::chrono_literals;
+
+const seconds warmup(5);
+
+// Every allocation made by a thread is counted here. It is per thread so the
+// manager workers (and the benchmark bookkeeping done outside of the measured
+// transactions) do not get in the way.
+thread_local uint64_t allocations = 0;
+
+auto operator new(std::size_t size) -> void* {
+  ++allocations;
+  if (auto ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+auto operator new(std::size_t size, std::align_val_t align) -> void* {
+  ++allocations;
+  auto alignment = static_cast<std::size_t>(align);
+  // aligned_alloc needs the size to be a multiple of the alignment
+  size = (size + alignment - 1) / alignment * alignment;
+  if (auto ptr = std::aligned_alloc(alignment, size == 0 ? alignment : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+// not inlined, otherwise GCC sees the `free` on memory that came from `new`
+// and warns about a mismatch
+__attribute__((noinline)) auto operator delete(void* ptr) noexcept -> void {
+  std::free(ptr);
+}
+__attribute__((noinline)) auto operator delete(void* ptr, std::size_t) noexcept
+    -> void {
+  std::free(ptr);
+}
+__attribute__((noinline)) auto operator delete(void* ptr,
+                                               std::align_val_t) noexcept
+    -> void {
+  std::free(ptr);
+}
+__attribute__((noinline)) auto operator delete(void* ptr, std::size_t,
+                                               std::align_val_t) noexcept
+    -> void {
+  std::free(ptr);
+}
+
+enum operation_t { read_op, add_op, sub_op, num_operations };
+
+const char* operation_names[] = {"read", "add", "sub"};
+
+struct result_t {
+  uint64_t operations[num_operations];
+  uint64_t allocations[num_operations];
+};
+
+struct options_t {
+  std::string benchmark;
+  size_t num_workers;
+  size_t read_percentage;
+  seconds duration;
+};
+
+template <splittable::splittable_type S>
+result_t run(options_t options) {
+  std::atomic_uint64_t total_operations[num_operations] = {};
+  std::atomic_uint64_t total_allocations[num_operations] = {};
+
+  // big enough for the subtractions to never run out of stock
+  auto value = S::new_instance(std::numeric_limits<uint32_t>::max() / 2);
+  S::global_init(options.num_workers);
+
+  auto threads = std::make_unique<std::thread[]>(options.num_workers);
+
+  boost::barrier bar(options.num_workers + 1);
+
+  for (size_t i = 0; i < options.num_workers; i++) {
+    threads[i] = std::thread([&, options]() {
+      S::thread_init();
+
+      uint64_t operations[num_operations] = {};
+      uint64_t allocations_per_op[num_operations] = {};
+      typename S::value_type val{};
+
+      auto pick_operation = [&]() {
+        if (splittable::utils::random_index(1, 100) <=
+            options.read_percentage) {
+          return read_op;
+        }
+        return splittable::utils::random_index(0, 1) == 0 ? add_op : sub_op;
+      };
+
+      auto execute = [&](operation_t op) {
+        WSTM::Atomically([&](WSTM::WAtomic& at) {
+          switch (op) {
+            case read_op:
+              val = value->read(at);
+              break;
+            case add_op:
+              value->add(at, 1);
+              break;
+            default:
+              value->sub(at, 1);
+              break;
+          }
+        });
+      };
+
+      bar.wait();
+
+      auto now = steady_clock::now;
+      auto start = now();
+
+      // lets the managers settle and every lazily allocated structure (both
+      // ours and WSTM's) be created before anything is counted
+      while ((now() - start) < warmup) {
+        execute(pick_operation());
+      }
+
+      start = now();
+
+      while ((now() - start) < options.duration) {
+        auto op = pick_operation();
+
+        auto before = allocations;
+        execute(op);
+        allocations_per_op[op] += allocations - before;
+        operations[op]++;
+      }
+
+      volatile auto avoid_optimisation __attribute__((unused)) = val;
+      for (auto op = 0; op < num_operations; ++op) {
+        total_operations[op].fetch_add(operations[op]);
+        total_allocations[op].fetch_add(allocations_per_op[op]);
+      }
+    });
+  }
+
+  bar.wait();
+
+  for (size_t i = 0; i < options.num_workers; i++) {
+    threads[i].join();
+  }
+
+  result_t result;
+  for (auto op = 0; op < num_operations; ++op) {
+    result.operations[op] = total_operations[op].load();
+    result.allocations[op] = total_allocations[op].load();
+  }
+  return result;
+}
+
+std::optional<result_t> run_benchmark(options_t options) {
+  if (options.benchmark == "single") {
+    return run<splittable::single::single<uint32_t>>(options);
+  } else if (options.benchmark == "mrv-flex-vector") {
+    using splittable_t = splittable::mrv::mrv_flex_vector<uint32_t>;
+    using splittable::mrv::balance_strategy_t;
+    splittable_t::set_balance_strategy(balance_strategy_t::none);
+    return run<splittable_t>(options);
+  } else if (options.benchmark == "pr-array") {
+    return run<splittable::pr::pr_array<uint32_t>>(options);
+  }
+
+  std::cerr << "could not find a benchmark with name \"" << options.benchmark
+            << "\"; try \"single\", \"mrv-flex-vector\", \"pr-array\"\n";
+  return std::nullopt;
+}
+
+int main(int argc, char const* argv[]) {
+  namespace po = boost::program_options;
+
+  options_t options;
+  po::options_description description("Allowed options");
+
+  // clang-format off
+  description.add_options()
+    ("help,h", "produce help message")
+    ("benchmark,b",
+      po::value<std::string>()->required(),
+      "set splittable type")
+    ("num_workers,w",
+      po::value<size_t>()->required(),
+      "set number of clients for the benchmark")
+    ("read_percentage,r",
+      po::value<size_t>()->required(),
+      "set percentage of read operations")
+    ("duration,d",
+      po::value<size_t>()->required(),
+      "set benchmark duration (in seconds)");
+  // clang-format on
+
+  po::variables_map vm;
+  po::store(po::parse_command_line(argc, argv, description), vm);
+  po::notify(vm);
+
+  options.benchmark = vm["benchmark"].as<std::string>();
+  options.num_workers = vm["num_workers"].as<size_t>();
+  options.read_percentage = vm["read_percentage"].as<size_t>();
+  options.duration = seconds{vm["duration"].as<size_t>()};
+
+  auto result = run_benchmark(options);
+  if (!result) {
+    return 1;
+  }
+
+  // CSV: benchmark, workers, execution time, read percentage, operation,
+  // committed operations, allocations, allocations per operation; this
+  // includes the allocations done by WSTM itself for each transaction
+  for (auto op = 0; op < num_operations; ++op) {
+    auto operations = result->operations[op];
+    auto allocations = result->allocations[op];
+    auto per_op =
+        operations == 0 ? 0.0 : static_cast<double>(allocations) / operations;
+
+    std::cout << options.benchmark << "," << options.num_workers << ","
+              << options.duration.count() << "," << options.read_percentage
+              << "," << operation_names[op] << "," << operations << ","
+              << allocations << "," << per_op << "\n";
+  }
+
+  quick_exit(0);
+}
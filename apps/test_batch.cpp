@@ -0,0 +1,272 @@
+#include <wstm/stm.h>
+
+#include <atomic>
+#include <boost/program_options.hpp>
+#include <boost/thread/barrier.hpp>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "splittable/batch.hpp"
+#include "splittable/mrv/mrv_flex_vector.hpp"
+#include "splittable/pr/pr_array.hpp"
+#include "splittable/single/single.hpp"
+#include "splittable/utils/random.hpp"
+
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+using namespace std::chrono_literals;
+
+const seconds warmup(5);
+
+struct result_t {
+  uint64_t transactions;
+  double abort_rate;
+};
+
+struct options_t {
+  std::string benchmark;
+  std::string mode;
+  size_t num_workers;
+  size_t num_objects;
+  size_t batch_size;
+  seconds duration;
+  size_t scale;
+};
+
+// a batch that runs out of value must count as one attempt of each object in
+// it, and not as an abort of any of them, since the transaction still commits
+template <splittable::splittable_type S>
+bool check_failed_batch() {
+  using splittable::batch_kind;
+  using splittable::batch_op;
+
+  if constexpr (requires(S s) { s.fetch_and_reset_status(); }) {
+    // not registered with the manager, so no adjust phase resets the counters
+    // before they are checked
+    auto first = std::make_shared<S>(1);
+    auto second = std::make_shared<S>(1);
+    std::vector<batch_op<S>> ops{{first.get(), batch_kind::add, 1},
+                                 {second.get(), batch_kind::sub, 2}};
+
+    auto applied = WSTM::Atomically([&](WSTM::WAtomic& at) {
+      return splittable::apply_batch<S>(at, std::span(ops));
+    });
+
+    for (auto& object : {first, second}) {
+      auto status = object->fetch_and_reset_status();
+
+      if (applied || status.aborts != 0 || status.commits != 1) {
+        std::cerr << "failed batch counted " << status.commits
+                  << " commit(s) and " << status.aborts
+                  << " abort(s) on an object; expected 1 and 0\n";
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+template <splittable::splittable_type S>
+std::optional<result_t> run(options_t options) {
+  if (!check_failed_batch<S>()) {
+    return std::nullopt;
+  }
+
+  using value_t = typename S::value_type;
+  using splittable::batch_kind;
+  using splittable::batch_op;
+
+  auto total_transactions = std::atomic_uint64_t(0);
+
+  std::vector<std::shared_ptr<S>> values;
+  for (auto i = 0u; i < options.num_objects; ++i) {
+    values.push_back(S::new_instance(static_cast<value_t>(options.scale)));
+  }
+  S::global_init(options.num_workers);
+
+  auto threads = std::make_unique<std::thread[]>(options.num_workers);
+
+  boost::barrier bar(options.num_workers + 1);
+
+  for (size_t i = 0; i < options.num_workers; i++) {
+    threads[i] = std::thread([&, options]() {
+      S::thread_init();
+
+      uint64_t transactions = 0;
+      // reused by every transaction, so the batch itself does not allocate
+      std::vector<batch_op<S>> ops(options.batch_size);
+
+      // same write mix as the microbenchmark: one add of `scale` per `scale`
+      // subs of 1
+      auto fill_batch = [&]() {
+        for (auto& op : ops) {
+          auto index = splittable::utils::random_index(0, values.size() - 1);
+          op.target = values[index].get();
+
+          if (splittable::utils::random_index(0, options.scale) == 0) {
+            op.kind = batch_kind::add;
+            op.value = static_cast<value_t>(options.scale);
+          } else {
+            op.kind = batch_kind::sub;
+            op.value = 1;
+          }
+        }
+      };
+
+      auto execute = [&]() -> bool {
+        if (options.mode == "batch") {
+          return WSTM::Atomically([&](WSTM::WAtomic& at) {
+            return splittable::apply_batch<S>(at, std::span(ops));
+          });
+        }
+
+        try {
+          WSTM::Atomically([&](WSTM::WAtomic& at) {
+            for (auto& op : ops) {
+              if (op.kind == batch_kind::add) {
+                op.target->add(at, op.value);
+              } else {
+                // aborts the whole transaction, like a failed batch
+                op.target->sub(at, op.value);
+              }
+            }
+          });
+        } catch (splittable::exception&) {
+          return false;
+        }
+
+        return true;
+      };
+
+      bar.wait();
+
+      auto now = steady_clock::now;
+      auto start = now();
+
+      while ((now() - start) < warmup) {
+        fill_batch();
+        execute();
+      }
+
+      S::reset_global_stats();
+      start = now();
+
+      while ((now() - start) < options.duration) {
+        fill_batch();
+
+        // batches that ran out of value are not counted, just like the subs
+        // with no stock in the microbenchmark
+        if (execute()) {
+          transactions++;
+        }
+      }
+
+      total_transactions.fetch_add(transactions);
+    });
+  }
+
+  bar.wait();
+
+  for (size_t i = 0; i < options.num_workers; i++) {
+    threads[i].join();
+  }
+
+  auto stats = splittable::splittable::get_global_stats();
+  auto abort_rate =
+      static_cast<double>(stats.aborts) / (stats.aborts + stats.commits);
+
+  return result_t{.transactions = total_transactions.load(),
+                  .abort_rate = abort_rate};
+}
+
+std::optional<result_t> run_benchmark(options_t options) {
+  if (options.benchmark == "single") {
+    return run<splittable::single::single<uint32_t>>(options);
+  } else if (options.benchmark == "mrv-flex-vector") {
+    using splittable_t = splittable::mrv::mrv_flex_vector<uint32_t>;
+    using splittable::mrv::balance_strategy_t;
+    splittable_t::set_balance_strategy(balance_strategy_t::none);
+    return run<splittable_t>(options);
+  } else if (options.benchmark == "pr-array") {
+    return run<splittable::pr::pr_array<uint32_t>>(options);
+  }
+
+  std::cerr << "could not find a benchmark with name \"" << options.benchmark
+            << "\"; try \"single\", \"mrv-flex-vector\", \"pr-array\"\n";
+  return std::nullopt;
+}
+
+int main(int argc, char const* argv[]) {
+  namespace po = boost::program_options;
+
+  options_t options;
+  po::options_description description("Allowed options");
+
+  // clang-format off
+  description.add_options()
+    ("help,h", "produce help message")
+    ("benchmark,b",
+      po::value<std::string>()->required(),
+      "set splittable type")
+    ("mode,m",
+      po::value<std::string>()->required(),
+      "set how the updates are applied (batch, loop)")
+    ("num_workers,w",
+      po::value<size_t>()->required(),
+      "set number of clients for the benchmark")
+    ("num_objects,o",
+      po::value<size_t>()->required(),
+      "set number of splittables the updates are spread over")
+    ("batch_size,n",
+      po::value<size_t>()->required(),
+      "set number of updates per transaction")
+    ("duration,d",
+      po::value<size_t>()->required(),
+      "set benchmark duration (in seconds)")
+    ("scale,s",
+      po::value<size_t>()->required(),
+      "set scale for writes (how big should adds be per sub)");
+  // clang-format on
+
+  po::variables_map vm;
+  po::store(po::parse_command_line(argc, argv, description), vm);
+  po::notify(vm);
+
+  options.benchmark = vm["benchmark"].as<std::string>();
+  options.mode = vm["mode"].as<std::string>();
+  options.num_workers = vm["num_workers"].as<size_t>();
+  options.num_objects = vm["num_objects"].as<size_t>();
+  options.batch_size = vm["batch_size"].as<size_t>();
+  options.duration = seconds{vm["duration"].as<size_t>()};
+  options.scale = vm["scale"].as<size_t>();
+
+  if (options.mode != "batch" && options.mode != "loop") {
+    std::cerr << "could not find a mode with name \"" << options.mode
+              << "\"; try \"batch\", \"loop\"\n";
+    return 1;
+  }
+
+  auto result = run_benchmark(options);
+  if (!result) {
+    return 1;
+  }
+
+  // CSV: benchmark, mode, workers, objects, batch size, execution time,
+  // transactions, throughput (transactions/s), abort rate
+  std::cout << options.benchmark << "," << options.mode << ","
+            << options.num_workers << "," << options.num_objects << ","
+            << options.batch_size << "," << options.duration.count() << ","
+            << result->transactions << ","
+            << static_cast<double>(result->transactions) /
+                   options.duration.count()
+            << "," << result->abort_rate << "\n";
+
+  quick_exit(0);
+}
@@ -0,0 +1,193 @@
+#include <wstm/stm.h>
+
+#include <atomic>
+#include <boost/program_options.hpp>
+#include <boost/thread/barrier.hpp>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "splittable/mrv/mrv_flex_vector.hpp"
+#include "splittable/utils/random.hpp"
+
+using std::chrono::microseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+using namespace std::chrono_literals;
+
+using splittable_t = splittable::mrv::mrv_flex_vector<uint64_t>;
+
+// long enough for a few adjust phases, so the object is shrunk down to what
+// the light load needs before the step
+const seconds warmup(4);
+
+// how often the monitor looks at the number of chunks
+const microseconds poll_interval(100);
+
+struct result_t {
+  uint64_t transactions;
+  size_t chunks_before;
+  size_t chunks_after;
+  // from the step until the object first has more chunks than before it; the
+  // whole duration if it never grew
+  double reaction_ms;
+  uint64_t reactive_growths;
+};
+
+struct options_t {
+  std::string growth;
+  size_t base_workers;
+  size_t num_workers;
+  seconds duration;
+  size_t scale;
+};
+
+result_t run(options_t options) {
+  // registered with the manager, since its reaction is what is measured
+  auto object = splittable_t::new_instance(options.scale);
+
+  std::atomic_bool stepped(false);
+  std::atomic_bool running(true);
+  std::atomic_uint64_t transactions(0);
+  std::vector<std::thread> threads;
+
+  auto execute = [&]() {
+    WSTM::Atomically([&](WSTM::WAtomic& at) {
+      if (splittable::utils::random_index(0, options.scale) == 0) {
+        object->add(at, options.scale);
+      } else {
+        object->try_sub(at, 1);
+      }
+    });
+  };
+
+  // the first `base_workers` run from the start; the others wait for the step
+  boost::barrier bar(options.num_workers - options.base_workers + 1);
+
+  for (auto i = 0u; i < options.num_workers; ++i) {
+    auto light = i < options.base_workers;
+
+    threads.emplace_back([&, light]() {
+      if (!light) {
+        bar.wait();
+      }
+
+      uint64_t count = 0;
+      while (running.load(std::memory_order_relaxed)) {
+        execute();
+
+        if (stepped.load(std::memory_order_relaxed)) {
+          ++count;
+        }
+      }
+
+      transactions.fetch_add(count);
+    });
+  }
+
+  std::this_thread::sleep_for(warmup);
+
+  splittable_t::reset_global_stats();
+  auto chunks_before = object->chunk_count();
+  auto step = steady_clock::now();
+  auto reaction = steady_clock::duration(options.duration);
+
+  stepped.store(true);
+  bar.wait();
+
+  while (steady_clock::now() - step < options.duration) {
+    auto now = steady_clock::now();
+
+    if (reaction == options.duration && object->chunk_count() > chunks_before) {
+      reaction = now - step;
+    }
+
+    std::this_thread::sleep_for(poll_interval);
+  }
+
+  running.store(false);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto reactive_growths =
+      splittable::mrv::manager::get_instance().get_reactive_growths();
+
+  return {.transactions = transactions.load(),
+          .chunks_before = chunks_before,
+          .chunks_after = object->chunk_count(),
+          .reaction_ms =
+              std::chrono::duration<double, std::milli>(reaction).count(),
+          .reactive_growths = reactive_growths};
+}
+
+int main(int argc, char const* argv[]) {
+  namespace po = boost::program_options;
+
+  options_t options;
+  po::options_description description("Allowed options");
+
+  // clang-format off
+  description.add_options()
+    ("help,h", "produce help message")
+    ("growth,g",
+      po::value<std::string>()->required(),
+      "set how objects grow (periodic, reactive)")
+    ("base_workers,b",
+      po::value<size_t>()->default_value(1),
+      "set number of clients running before the step")
+    ("num_workers,w",
+      po::value<size_t>()->required(),
+      "set number of clients running after the step")
+    ("duration,d",
+      po::value<size_t>()->required(),
+      "set how long to run after the step (in seconds)")
+    ("scale,s",
+      po::value<size_t>()->required(),
+      "set scale for writes (how big should adds be per sub)");
+  // clang-format on
+
+  po::variables_map vm;
+  po::store(po::parse_command_line(argc, argv, description), vm);
+  po::notify(vm);
+
+  options.growth = vm["growth"].as<std::string>();
+  options.base_workers = vm["base_workers"].as<size_t>();
+  options.num_workers = vm["num_workers"].as<size_t>();
+  options.duration = seconds{vm["duration"].as<size_t>()};
+  options.scale = vm["scale"].as<size_t>();
+
+  if (options.base_workers > options.num_workers) {
+    std::cerr << "there cannot be more clients before the step than after\n";
+    return 1;
+  }
+
+  splittable_t::set_balance_strategy(
+      splittable::mrv::balance_strategy_t::none);
+
+  if (options.growth == "periodic") {
+    splittable_t::set_reactive_growth(false);
+  } else if (options.growth == "reactive") {
+    splittable_t::set_reactive_growth(true);
+  } else {
+    std::cerr << "could not find a growth mode with name \"" << options.growth
+              << "\"; try \"periodic\", \"reactive\"\n";
+    return 1;
+  }
+
+  auto result = run(options);
+
+  // CSV: growth, base workers, workers, execution time, transactions, chunks
+  // before the step, chunks at the end, reaction time (ms), reactive growths
+  std::cout << options.growth << "," << options.base_workers << ","
+            << options.num_workers << "," << options.duration.count() << ","
+            << result.transactions << "," << result.chunks_before << ","
+            << result.chunks_after << "," << result.reaction_ms << ","
+            << result.reactive_growths << "\n";
+
+  quick_exit(0);
+}
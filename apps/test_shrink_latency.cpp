@@ -0,0 +1,251 @@
+#include <wstm/stm.h>
+
+#include <algorithm>
+#include <atomic>
+#include <boost/program_options.hpp>
+#include <boost/thread/barrier.hpp>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "splittable/mrv/mrv_flex_vector.hpp"
+#include "splittable/utils/random.hpp"
+
+using std::chrono::microseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+using namespace std::chrono_literals;
+
+using splittable_t = splittable::mrv::mrv_flex_vector<uint64_t>;
+
+const seconds warmup(2);
+
+// transactions are bucketed by latency, one bucket per microsecond; the last
+// one takes everything slower
+const size_t MAX_LATENCY_US = 100'000;
+
+using histogram_t = std::vector<uint64_t>;
+
+struct result_t {
+  uint64_t transactions;
+  uint64_t shrinks;
+  double p50_us;
+  double p99_us;
+  double p999_us;
+  double max_us;
+};
+
+struct options_t {
+  std::string removal;
+  size_t num_workers;
+  size_t num_objects;
+  size_t grow_steps;
+  seconds duration;
+  size_t scale;
+};
+
+auto percentile(const histogram_t& histogram, uint64_t total, double p)
+    -> double {
+  auto target = static_cast<uint64_t>(p * total);
+  uint64_t seen = 0;
+
+  for (auto i = 0u; i < histogram.size(); ++i) {
+    seen += histogram[i];
+    if (seen > target) {
+      return i;
+    }
+  }
+
+  return histogram.size() - 1;
+}
+
+result_t run(options_t options) {
+  // the objects are not registered with the manager, so the shrinker below is
+  // the only one resizing them, and the clients' objects are never resized
+  std::vector<std::shared_ptr<splittable_t>> hot;
+  for (auto i = 0u; i < options.num_workers; ++i) {
+    hot.push_back(std::make_shared<splittable_t>(options.scale));
+  }
+
+  std::vector<std::shared_ptr<splittable_t>> idle;
+  for (auto i = 0u; i < options.num_objects; ++i) {
+    idle.push_back(std::make_shared<splittable_t>(options.scale));
+  }
+
+  std::atomic_bool running(true);
+  std::atomic_bool measuring(false);
+  std::atomic_uint64_t shrinks(0);
+
+  // grows every idle object and then shrinks it back down to one chunk, over
+  // and over, like the adjust phase does after a burst
+  std::thread shrinker([&]() {
+    while (running.load()) {
+      for (auto& object : idle) {
+        for (auto step = 0u; step < options.grow_steps; ++step) {
+          object->add_nodes(1.0);
+        }
+      }
+
+      for (auto step = 0u; step < options.grow_steps; ++step) {
+        for (auto& object : idle) {
+          object->remove_nodes(0.0);
+
+          if (measuring.load()) {
+            shrinks.fetch_add(1);
+          }
+        }
+      }
+    }
+  });
+
+  std::vector<histogram_t> histograms(options.num_workers,
+                                      histogram_t(MAX_LATENCY_US + 1, 0));
+  std::vector<std::thread> threads;
+
+  boost::barrier bar(options.num_workers + 1);
+
+  for (auto i = 0u; i < options.num_workers; ++i) {
+    threads.emplace_back([&, i]() {
+      auto& object = *hot[i];
+      auto& histogram = histograms[i];
+
+      auto execute = [&]() {
+        WSTM::Atomically([&](WSTM::WAtomic& at) {
+          if (splittable::utils::random_index(0, options.scale) == 0) {
+            object.add(at, options.scale);
+          } else {
+            object.try_sub(at, 1);
+          }
+        });
+      };
+
+      bar.wait();
+
+      auto now = steady_clock::now;
+      auto start = now();
+
+      while ((now() - start) < warmup) {
+        execute();
+      }
+
+      bar.wait();
+      start = now();
+
+      while ((now() - start) < options.duration) {
+        auto before = now();
+        execute();
+        auto latency =
+            std::chrono::duration_cast<microseconds>(now() - before).count();
+
+        histogram[std::min<size_t>(latency, MAX_LATENCY_US)]++;
+      }
+    });
+  }
+
+  bar.wait();
+  bar.wait();
+  measuring.store(true);
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  measuring.store(false);
+  running.store(false);
+  shrinker.join();
+
+  histogram_t total(MAX_LATENCY_US + 1, 0);
+  uint64_t transactions = 0;
+  for (auto& histogram : histograms) {
+    for (auto i = 0u; i < histogram.size(); ++i) {
+      total[i] += histogram[i];
+      transactions += histogram[i];
+    }
+  }
+
+  double max_us = 0;
+  for (auto i = total.size(); i > 0; --i) {
+    if (total[i - 1] > 0) {
+      max_us = i - 1;
+      break;
+    }
+  }
+
+  return {.transactions = transactions,
+          .shrinks = shrinks.load(),
+          .p50_us = percentile(total, transactions, 0.5),
+          .p99_us = percentile(total, transactions, 0.99),
+          .p999_us = percentile(total, transactions, 0.999),
+          .max_us = max_us};
+}
+
+int main(int argc, char const* argv[]) {
+  namespace po = boost::program_options;
+
+  options_t options;
+  po::options_description description("Allowed options");
+
+  // clang-format off
+  description.add_options()
+    ("help,h", "produce help message")
+    ("removal,r",
+      po::value<std::string>()->required(),
+      "set how chunks are removed (locked, draining)")
+    ("num_workers,w",
+      po::value<size_t>()->required(),
+      "set number of clients for the benchmark")
+    ("num_objects,o",
+      po::value<size_t>()->required(),
+      "set number of idle objects that are grown and shrunk")
+    ("grow_steps,g",
+      po::value<size_t>()->default_value(5),
+      "set number of `add_nodes` calls each idle object is grown by")
+    ("duration,d",
+      po::value<size_t>()->required(),
+      "set benchmark duration (in seconds)")
+    ("scale,s",
+      po::value<size_t>()->required(),
+      "set scale for writes (how big should adds be per sub)");
+  // clang-format on
+
+  po::variables_map vm;
+  po::store(po::parse_command_line(argc, argv, description), vm);
+  po::notify(vm);
+
+  options.removal = vm["removal"].as<std::string>();
+  options.num_workers = vm["num_workers"].as<size_t>();
+  options.num_objects = vm["num_objects"].as<size_t>();
+  options.grow_steps = vm["grow_steps"].as<size_t>();
+  options.duration = seconds{vm["duration"].as<size_t>()};
+  options.scale = vm["scale"].as<size_t>();
+
+  using splittable::mrv::balance_strategy_t;
+  using splittable::mrv::removal_strategy_t;
+  splittable_t::set_balance_strategy(balance_strategy_t::none);
+
+  if (options.removal == "locked") {
+    splittable_t::set_removal_strategy(removal_strategy_t::locked);
+  } else if (options.removal == "draining") {
+    splittable_t::set_removal_strategy(removal_strategy_t::draining);
+  } else {
+    std::cerr << "could not find a removal strategy with name \""
+              << options.removal << "\"; try \"locked\", \"draining\"\n";
+    return 1;
+  }
+
+  auto result = run(options);
+
+  // CSV: removal, workers, objects, execution time, transactions, shrinks,
+  // p50 latency (us), p99 latency (us), p99.9 latency (us), max latency (us)
+  std::cout << options.removal << "," << options.num_workers << ","
+            << options.num_objects << "," << options.duration.count() << ","
+            << result.transactions << "," << result.shrinks << ","
+            << result.p50_us << "," << result.p99_us << "," << result.p999_us
+            << "," << result.max_us << "\n";
+
+  quick_exit(0);
+}
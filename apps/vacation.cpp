@@ -10,15 +10,21 @@
 #include <cstdlib>
 #include <iostream>
 #include <random>
+#include <type_traits>
 
 #include "splittable/benchmarks/vacation/client.h"
 #include "splittable/benchmarks/vacation/manager.h"
 #include "splittable/benchmarks/vacation/thread.h"
 #include "splittable/benchmarks/vacation/timer.h"
 #include "splittable/benchmarks/vacation/utility.h"
+#include "splittable/utils/numa.hpp"
 
 enum param_types {
+  PARAM_COALESCE = (unsigned char)'c',
   PARAM_CLIENTS = (unsigned char)'t',
+  PARAM_MANAGER_BUDGET = (unsigned char)'B',
+  PARAM_MANAGER_CPUS = (unsigned char)'p',
+  PARAM_MANAGER_THREADS = (unsigned char)'m',
   PARAM_NUMBER = (unsigned char)'n',
   PARAM_QUERIES = (unsigned char)'q',
   PARAM_RELATIONS = (unsigned char)'r',
@@ -28,7 +34,11 @@ enum param_types {
   PARAM_USER = (unsigned char)'u'
 };
 
+#define PARAM_DEFAULT_COALESCE (0)
 #define PARAM_DEFAULT_CLIENTS (1)
+#define PARAM_DEFAULT_MANAGER_BUDGET (0)
+#define PARAM_DEFAULT_MANAGER_CPUS ""
+#define PARAM_DEFAULT_MANAGER_THREADS (-1)
 #define PARAM_DEFAULT_NUMBER (4)
 #define PARAM_DEFAULT_QUERIES (60)
 #define PARAM_DEFAULT_RELATIONS (1 << 20)
@@ -40,6 +50,7 @@ enum param_types {
 double global_params[256]; /* 256 = ascii limit */
 std::string global_splittable_type;
 std::string global_splittable_mrv_balance;
+std::string global_manager_cpus;
 
 pthread_barrier_t* global_barrierPtr;
 
@@ -50,8 +61,18 @@ pthread_barrier_t* global_barrierPtr;
 static void displayUsage(const char* appName) {
   printf("Usage: %s [options]\n", appName);
   puts("\nOptions:                                             (defaults)\n");
+  printf("    c          [c]oalesce additions per transaction  (%i)\n",
+         PARAM_DEFAULT_COALESCE);
   printf("    t <UINT>   Number of clien[t]s ([t]hreads)       (%i)\n",
          PARAM_DEFAULT_CLIENTS);
+  printf("    m <INT>    Number of [m]anager threads           (%i)\n",
+         PARAM_DEFAULT_MANAGER_THREADS);
+  puts("                 (-1 uses the default, 0 runs the passes on the\n"
+       "                 manager thread itself)");
+  printf("    p <STR>    CPUs the manager threads are [p]inned to (\"%s\")\n",
+         PARAM_DEFAULT_MANAGER_CPUS);
+  printf("    B <UINT>   CPU time [B]udget per manager pass (us) (%i)\n",
+         PARAM_DEFAULT_MANAGER_BUDGET);
   printf("    n <UINT>   [n]umber of user queries/transaction  (%i)\n",
          PARAM_DEFAULT_NUMBER);
   printf("    q <UINT>   Percentage of relations [q]ueried     (%i)\n",
@@ -74,7 +95,11 @@ static void displayUsage(const char* appName) {
  * =============================================================================
  */
 static void setDefaultParams() {
+  global_params[PARAM_COALESCE] = PARAM_DEFAULT_COALESCE;
   global_params[PARAM_CLIENTS] = PARAM_DEFAULT_CLIENTS;
+  global_params[PARAM_MANAGER_BUDGET] = PARAM_DEFAULT_MANAGER_BUDGET;
+  global_manager_cpus = PARAM_DEFAULT_MANAGER_CPUS;
+  global_params[PARAM_MANAGER_THREADS] = PARAM_DEFAULT_MANAGER_THREADS;
   global_params[PARAM_NUMBER] = PARAM_DEFAULT_NUMBER;
   global_params[PARAM_QUERIES] = PARAM_DEFAULT_QUERIES;
   global_params[PARAM_RELATIONS] = PARAM_DEFAULT_RELATIONS;
@@ -96,8 +121,10 @@ static void parseArgs(long argc, char* const argv[]) {
 
   setDefaultParams();
 
-  while ((opt = getopt(argc, argv, "t:n:q:r:s:b:T:u:L")) != -1) {
+  while ((opt = getopt(argc, argv, "ct:n:q:r:s:b:T:u:Lm:p:B:")) != -1) {
     switch (opt) {
+      case 'B':
+      case 'm':
       case 'T':
       case 'n':
       case 'q':
@@ -106,6 +133,9 @@ static void parseArgs(long argc, char* const argv[]) {
       case 'u':
         global_params[(unsigned char)opt] = atol(optarg);
         break;
+      case 'c':
+        global_params[PARAM_COALESCE] = 1;
+        break;
       case 'L':
         global_params[PARAM_NUMBER] = 2;
         global_params[PARAM_QUERIES] = 90;
@@ -114,12 +144,12 @@ static void parseArgs(long argc, char* const argv[]) {
       case 's': {
         std::string type(optarg);
         if (type == "single" || type == "mrv-flex-vector" ||
-            type == "pr-array") {
+            type == "mrv-array" || type == "pr-array") {
           global_splittable_type = type;
         } else {
           fprintf(stderr,
                   "Could not find a benchmark with name %s; try \"single\", "
-                  "\"mrv-flex-vector\", \"pr-array\"\n",
+                  "\"mrv-flex-vector\", \"mrv-array\", \"pr-array\"\n",
                   type.c_str());
           opterr++;
         }
@@ -128,6 +158,9 @@ static void parseArgs(long argc, char* const argv[]) {
       case 'b':
         global_splittable_mrv_balance = optarg;
         break;
+      case 'p':
+        global_manager_cpus = optarg;
+        break;
       case '?':
       default:
         opterr++;
@@ -375,12 +408,21 @@ int templated_main() {
       static_cast<double>(stats.aborts) / (stats.aborts + stats.commits);
 
   std::string type("");
-  if (global_splittable_type == "mrv-flex-vector") {
+  if (global_splittable_type == "mrv-flex-vector" ||
+      global_splittable_type == "mrv-array") {
     type = global_splittable_type + ".balance-" + global_splittable_mrv_balance;
   } else {
     type = global_splittable_type;
   }
 
+  if (!std::is_same_v<vacation_value_t, uint32_t>) {
+    type += ".value-" + vacation_value_name();
+  }
+
+  if (global_params[PARAM_COALESCE]) {
+    type += ".coalesce";
+  }
+
   // benchmark, workers, execution time (s), abort rate, avg adjust interval
   // (ms), avg balance interval (ms), avg phase interval (ms)
   std::cout << type << "," << numThread << ","
@@ -402,37 +444,87 @@ int templated_main() {
                   // correctly
 }
 
+/* =============================================================================
+ * set_mrv_balance
+ * -- Returns false if the balance given in the arguments does not exist
+ * =============================================================================
+ */
+template <typename M>
+static bool set_mrv_balance() {
+  using splittable::mrv::balance_strategy_t;
+
+  auto balance = global_splittable_mrv_balance;
+  if (balance == "none") {
+    M::set_balance_strategy(balance_strategy_t::none);
+  } else if (balance == "random") {
+    M::set_balance_strategy(balance_strategy_t::random);
+  } else if (balance == "minmax") {
+    M::set_balance_strategy(balance_strategy_t::minmax);
+  } else if (balance == "all") {
+    M::set_balance_strategy(balance_strategy_t::all);
+  } else {
+    std::cerr << "could not find a balance type with name \"" << balance
+              << "\"; try \"none\", \"random\", \"minmax\", \"all\"\n";
+    return false;
+  }
+
+  return true;
+}
+
+/* =============================================================================
+ * configure_managers
+ * -- Sets up the threads the manager of the chosen type adjusts objects with
+ * =============================================================================
+ */
+static void configure_managers() {
+  splittable::utils::worker_pool_options pool;
+
+  if (global_params[PARAM_MANAGER_THREADS] >= 0) {
+    pool.threads = global_params[PARAM_MANAGER_THREADS];
+  }
+  pool.cpus = splittable::utils::parse_cpu_list(global_manager_cpus);
+  pool.cpu_budget =
+      std::chrono::microseconds((long)global_params[PARAM_MANAGER_BUDGET]);
+
+  if (global_splittable_type.starts_with("mrv")) {
+    splittable::mrv::manager::get_instance().configure_pool(pool);
+  } else if (global_splittable_type.starts_with("pr")) {
+    splittable::pr::manager::get_instance().configure_pool(pool);
+  }
+}
+
 int main(int argc, char** argv) {
   parseArgs(argc, argv);
 
+  splittable::splittable::set_delta_coalescing(global_params[PARAM_COALESCE]);
+  configure_managers();
+
   if (global_splittable_type == "single") {
-    return templated_main<splittable::single::single>();
+    return templated_main<splittable::single::single<vacation_value_t>>();
   }
 
   if (global_splittable_type == "mrv-flex-vector") {
-    using splittable::mrv::balance_strategy_t;
-    using splittable::mrv::mrv_flex_vector;
-
-    auto balance = global_splittable_mrv_balance;
-    if (balance == "none") {
-      mrv_flex_vector::set_balance_strategy(balance_strategy_t::none);
-    } else if (balance == "random") {
-      mrv_flex_vector::set_balance_strategy(balance_strategy_t::random);
-    } else if (balance == "minmax") {
-      mrv_flex_vector::set_balance_strategy(balance_strategy_t::minmax);
-    } else if (balance == "all") {
-      mrv_flex_vector::set_balance_strategy(balance_strategy_t::all);
-    } else {
-      std::cerr << "could not find a balance type with name \"" << balance
-                << "\"; try \"none\", \"random\", \"minmax\", \"all\"\n";
+    using mrv_flex_vector = splittable::mrv::mrv_flex_vector<vacation_value_t>;
+
+    if (!set_mrv_balance<mrv_flex_vector>()) {
       return 1;
     }
 
     return templated_main<mrv_flex_vector>();
   }
 
+  if (global_splittable_type == "mrv-array") {
+    using mrv_array = splittable::mrv::mrv_array<vacation_value_t>;
+
+    if (!set_mrv_balance<mrv_array>()) {
+      return 1;
+    }
+
+    return templated_main<mrv_array>();
+  }
+
   if (global_splittable_type == "pr-array") {
-    return templated_main<splittable::pr::pr_array>();
+    return templated_main<splittable::pr::pr_array<vacation_value_t>>();
   }
 
   // Should be impossible to reach here.
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <wstm/stm.h>
+
+#include <concepts>
+#include <memory>
+
+#include "splittable/splittable.hpp"
+
+namespace splittable {
+
+/// @brief Type-erased handle over any `splittable_type`. Only meant for the
+/// places that really need to mix different splittable types at runtime; hot
+/// paths should be templated on the concrete type instead, since every call
+/// here goes through a virtual function.
+template <std::integral V>
+class any_splittable {
+ private:
+  struct concept_t {
+    virtual ~concept_t() = default;
+
+    auto virtual read(WSTM::WAtomic& at) -> V = 0;
+    auto virtual inconsistent_read(WSTM::WInconsistent& inc) -> V = 0;
+    auto virtual add(WSTM::WAtomic& at, V value) -> void = 0;
+    auto virtual sub(WSTM::WAtomic& at, V value) -> void = 0;
+    auto virtual try_sub(WSTM::WAtomic& at, V value) -> bool = 0;
+    auto virtual track(WSTM::WAtomic& at) -> void = 0;
+  };
+
+  template <splittable_type S>
+    requires std::same_as<typename S::value_type, V>
+  struct model_t final : public concept_t {
+    std::shared_ptr<S> value;
+
+    model_t(std::shared_ptr<S> value) : value(std::move(value)) {}
+
+    auto read(WSTM::WAtomic& at) -> V override {
+      return this->value->read(at);
+    }
+
+    auto inconsistent_read(WSTM::WInconsistent& inc) -> V override {
+      return this->value->inconsistent_read(inc);
+    }
+
+    auto add(WSTM::WAtomic& at, V value) -> void override {
+      this->value->add(at, value);
+    }
+
+    auto sub(WSTM::WAtomic& at, V value) -> void override {
+      this->value->sub(at, value);
+    }
+
+    auto try_sub(WSTM::WAtomic& at, V value) -> bool override {
+      return this->value->try_sub(at, value);
+    }
+
+    auto track(WSTM::WAtomic& at) -> void override { this->value->track(at); }
+  };
+
+  std::shared_ptr<concept_t> self;
+
+ public:
+  template <splittable_type S>
+    requires std::same_as<typename S::value_type, V>
+  any_splittable(std::shared_ptr<S> value)
+      : self(std::make_shared<model_t<S>>(std::move(value))) {}
+
+  auto read(WSTM::WAtomic& at) -> V { return this->self->read(at); }
+  auto inconsistent_read(WSTM::WInconsistent& inc) -> V {
+    return this->self->inconsistent_read(inc);
+  }
+  auto add(WSTM::WAtomic& at, V value) -> void { this->self->add(at, value); }
+  auto sub(WSTM::WAtomic& at, V value) -> void { this->self->sub(at, value); }
+  auto try_sub(WSTM::WAtomic& at, V value) -> bool {
+    return this->self->try_sub(at, value);
+  }
+  auto track(WSTM::WAtomic& at) -> void { this->self->track(at); }
+};
+
+}  // namespace splittable
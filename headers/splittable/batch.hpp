@@ -0,0 +1,104 @@
+#pragma once
+
+#include <wstm/stm.h>
+
+#include <span>
+
+#include "splittable/splittable.hpp"
+
+namespace splittable {
+
+enum class batch_kind { add, sub };
+
+/// @brief One update of a batch: adds or subtracts `value` from `target`.
+template <splittable_type S>
+struct batch_op {
+  S* target;
+  batch_kind kind;
+  typename S::value_type value;
+};
+
+/// @brief Applies every update in `ops` within the transaction `at`, all or
+/// nothing. The updates are first netted per object, so each object only has
+/// its directory loaded, its tracking set up and its chunks touched once, and
+/// a single read lock is held for the whole batch.
+/// @return false, with nothing applied, if one of the objects does not have
+/// enough value for its net subtraction; the transaction itself can still
+/// commit.
+template <splittable_type S>
+auto apply_batch(WSTM::WAtomic& at, std::span<const batch_op<S>> ops) -> bool {
+  using V = typename S::value_type;
+
+  auto apply = [&](WSTM::WAtomic& at) {
+    WSTM::WReadLockGuard<WSTM::WAtomic> lock(at);
+
+    for (auto i = 0u; i < ops.size(); ++i) {
+      auto target = ops[i].target;
+
+      // the object was already handled with its first update; batches are
+      // expected to be small, so a quadratic scan beats allocating a map
+      auto seen = false;
+      for (auto j = 0u; j < i && !seen; ++j) {
+        seen = ops[j].target == target;
+      }
+      if (seen) {
+        continue;
+      }
+
+      V added = 0;
+      V subtracted = 0;
+      for (auto j = i; j < ops.size(); ++j) {
+        if (ops[j].target != target) {
+          continue;
+        }
+
+        auto& total = ops[j].kind == batch_kind::add ? added : subtracted;
+        if (would_overflow(total, ops[j].value)) {
+          throw exception(error::overflow);
+        }
+        total += ops[j].value;
+      }
+
+      if (added > subtracted) {
+        target->add(at, added - subtracted);
+      } else if (subtracted > added &&
+                 !target->try_sub(at, subtracted - added)) {
+        throw exception(error::insufficient_value);
+      }
+    }
+  };
+
+  auto has_subs = false;
+  for (auto& op : ops) {
+    has_subs = has_subs || op.kind == batch_kind::sub;
+  }
+
+  // additions cannot run out of value, so only batches with subtractions pay
+  // for the child transaction that undoes the partial work on failure
+  if (!has_subs) {
+    apply(at);
+    return true;
+  }
+
+  // the tracking is set up here, in the parent, so that the child finds it
+  // already set up: registered in the child, its `OnFail` would count an abort
+  // on every object when the batch runs out of value, and a later operation of
+  // the parent would count a second attempt, since the child's flags are rolled
+  // back with it
+  for (auto& op : ops) {
+    op.target->track(at);
+  }
+
+  try {
+    WSTM::Atomically(apply);
+  } catch (exception& ex) {
+    if (ex.err != error::insufficient_value) {
+      throw;
+    }
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace splittable
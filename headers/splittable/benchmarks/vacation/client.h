@@ -11,6 +11,7 @@
 
 #include "action.h"
 #include "manager.h"
+#include "splittable/mrv/mrv_array.hpp"
 #include "splittable/mrv/mrv_flex_vector.hpp"
 #include "splittable/pr/pr_array.hpp"
 #include "splittable/single/single.hpp"
@@ -15,6 +15,7 @@
 
 #include "customer.h"
 #include "reservation.h"
+#include "splittable/mrv/mrv_array.hpp"
 #include "splittable/mrv/mrv_flex_vector.hpp"
 #include "splittable/pr/pr_array.hpp"
 #include "splittable/single/single.hpp"
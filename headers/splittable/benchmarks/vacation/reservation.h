@@ -11,11 +11,29 @@
 #include <wstm/stm.h>
 
 #include <boost/functional/hash.hpp>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <type_traits>
 
 #include "splittable/splittable.hpp"
 #include "utility.h"
 
+// The counter type of the splittable values is chosen at build time (e.g.
+// `-DVACATION_VALUE_TYPE=uint64_t`), to keep the number of instantiations of
+// the benchmark down.
+#ifndef VACATION_VALUE_TYPE
+#define VACATION_VALUE_TYPE uint32_t
+#endif
+
+using vacation_value_t = VACATION_VALUE_TYPE;
+
+// Name used in the CSV output, e.g. "uint32" or "int64".
+inline auto vacation_value_name() -> std::string {
+  return (std::is_signed_v<vacation_value_t> ? "int" : "uint") +
+         std::to_string(sizeof(vacation_value_t) * 8);
+}
+
 enum reservation_type_t {
   RESERVATION_CAR,
   RESERVATION_FLIGHT,
@@ -52,7 +70,7 @@ struct equal_to<::reservation_info_t> {
 };
 }  // namespace std
 
-template <typename S>
+template <splittable::splittable_type S>
 struct reservation_t {
   long id;
   WSTM::WVar<long> numUsed;
@@ -61,9 +79,11 @@ struct reservation_t {
   WSTM::WVar<long> numTotal;
   WSTM::WVar<long> price;
 
+  using value_t = typename S::value_type;
+
   reservation_t(long _id, long _price, long _numTotal, bool* success)
       : id(_id), numUsed(0), numTotal(_numTotal), price(_price) {
-    numFree = S::new_instance(_numTotal);
+    numFree = S::new_instance(static_cast<value_t>(_numTotal));
     *success = WSTM::Atomically(
         [this](WSTM::WAtomic& at) -> bool { return checkReservation(at); });
   }
@@ -77,17 +97,13 @@ struct reservation_t {
    */
   bool addToTotal(WSTM::WAtomic& at, long num, bool* success) {
     if (num < 0) {
-      try {
-        // we start a new transaction here to avoid having an half-done
-        // subtraction. doing it this way, we can rollback the subtraction.
-        WSTM::Atomically([this, num](WSTM::WAtomic& at2) {
-          numFree->sub(at2, static_cast<uint>(-num));
-        });
-      } catch (...) {
+      // try_sub leaves the value untouched when it fails, so there is no
+      // half-done subtraction to roll back
+      if (!numFree->try_sub(at, static_cast<value_t>(-num))) {
         return false;
       }
     } else {
-      numFree->add(at, static_cast<uint>(num));
+      numFree->add(at, static_cast<value_t>(num));
     }
 
     auto num_total = numTotal.Get(at);
@@ -103,11 +119,7 @@ struct reservation_t {
    * -- Returns TRUE on success, else FALSE
    */
   bool make(WSTM::WAtomic& at) {
-    try {
-      // we start a new transaction here to avoid having an half-done
-      // subtraction. doing it this way, we can rollback the subtraction.
-      WSTM::Atomically([this](WSTM::WAtomic& at2) { numFree->sub(at2, 1); });
-    } catch (...) {
+    if (!numFree->try_sub(at, 1)) {
       return false;
     }
 
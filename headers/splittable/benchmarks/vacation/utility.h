@@ -73,6 +73,7 @@
 
 #include <exception>
 
+#include "splittable/mrv/mrv_array.hpp"
 #include "splittable/mrv/mrv_flex_vector.hpp"
 #include "splittable/pr/pr_array.hpp"
 #include "splittable/single/single.hpp"
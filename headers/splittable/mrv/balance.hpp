@@ -0,0 +1,182 @@
+#pragma once
+
+#include <wstm/stm.h>
+
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "splittable/mrv/mrv.hpp"
+#include "splittable/mrv/snapshot.hpp"
+#include "splittable/utils/random.hpp"
+
+namespace splittable::mrv {
+
+enum class balance_strategy_t { none, random, minmax, all };
+
+// The strategies that look at every chunk take a `snapshot` of them first and
+// run over that, so each chunk is read once and the scans over the values can
+// be vectorized.
+
+template <std::integral V, typename Chunks>
+auto balance_all(WSTM::WAtomic& at, Chunks& chunks) -> void {
+  auto size = chunks.size();
+
+  if (size < 2) {
+    throw exception();
+  }
+
+  auto total = snapshot_sum(snapshot<V>(at, chunks));
+  // in the type of the sum, so a signed total is not divided as unsigned
+  auto count = static_cast<sum_t<V>>(size);
+
+  // TODO: check for unneeded balances; not sure if it is feasible here, we
+  // would have to make many comparisons just to check if we need to abort,
+  // seems like it would incur in a big overhead
+
+  V new_value = total / count;
+  V remainder = total % count;
+
+  as_chunk(chunks[0]).Set(new_value + remainder, at);
+  for (auto i = 1u; i < size; ++i) {
+    as_chunk(chunks[i]).Set(new_value, at);
+  }
+}
+
+template <std::integral V, typename Chunks>
+auto balance_minmax(WSTM::WAtomic& at, Chunks& chunks) -> void {
+  auto size = chunks.size();
+
+  if (size < 2) {
+    throw exception();
+  }
+
+  auto values = snapshot<V>(at, chunks);
+  auto [min_i, max_i] = snapshot_minmax(values);
+  auto min_v = values[min_i];
+  auto max_v = values[max_i];
+
+  if (min_i == max_i || max_v - min_v <= static_cast<V>(MIN_BALANCE_DIFF)) {
+    throw exception();
+  }
+
+  // written this way to avoid overflowing when both values are large
+  auto new_value = min_v + (max_v - min_v) / 2;
+  auto remainder = (max_v - min_v) % 2;
+
+  as_chunk(chunks[min_i]).Set(new_value + remainder, at);
+  as_chunk(chunks[max_i]).Set(new_value, at);
+}
+
+auto constexpr calculate_k(size_t num_records) -> size_t {
+  if (num_records < 4) {
+    return 1;
+  }
+
+  if (num_records <= 16) {
+    return 2;
+  }
+
+  if (num_records < 64) {
+    return num_records / 8;
+  }
+
+  return num_records / 16;
+}
+
+template <std::integral V, typename Chunks>
+auto balance_minmax_with_k(WSTM::WAtomic& at, Chunks& chunks) -> void {
+  auto size = chunks.size();
+
+  if (size < 2) {
+    throw exception();
+  }
+
+  const uint k = calculate_k(size);
+
+  auto values = snapshot<V>(at, chunks);
+  auto indexes = snapshot_top_k(values, k);
+
+  // see `balance_all`
+  sum_t<V> total = 0;
+  for (auto i : indexes) {
+    total += values[i];
+  }
+  auto count = static_cast<sum_t<V>>(k + k);
+
+  // TODO: check for unneeded balances
+  // if (min_i == max_i || max_v - min_v <= MIN_BALANCE_DIFF) {
+  //   throw exception();
+  // }
+
+  V new_value = total / count;
+  V remainder = total % count;
+
+  for (auto i : indexes) {
+    if (i == indexes[0]) {
+      as_chunk(chunks[i]).Set(new_value + remainder, at);
+    } else {
+      as_chunk(chunks[i]).Set(new_value, at);
+    }
+  }
+}
+
+template <std::integral V, typename Chunks>
+auto balance_none(WSTM::WAtomic&, Chunks&) -> void {}
+
+template <std::integral V, typename Chunks>
+auto balance_random(WSTM::WAtomic& at, Chunks& chunks) -> void {
+  auto size = chunks.size();
+
+  if (size < 2) {
+    throw exception();
+  }
+
+  auto i = utils::random_index(0, size - 1);
+  auto j = utils::random_index(0, size - 1);
+
+  if (i == j) {
+    j = (i + 1) % size;
+  }
+
+  auto i_val = as_chunk(chunks[i]).Get(at);
+  auto j_val = as_chunk(chunks[j]).Get(at);
+
+  const auto min_diff = static_cast<V>(MIN_BALANCE_DIFF);
+  if (i_val == j_val || (i_val > j_val && i_val - j_val <= min_diff) ||
+      (i_val < j_val && j_val - i_val <= min_diff)) {
+    throw exception();
+  }
+
+  // written this way to avoid overflowing when both values are large
+  auto new_value = std::min(i_val, j_val) + (std::max(i_val, j_val) -
+                                             std::min(i_val, j_val)) / 2;
+  auto remainder = (std::max(i_val, j_val) - std::min(i_val, j_val)) % 2;
+
+  as_chunk(chunks[i]).Set(new_value + remainder, at);
+  as_chunk(chunks[j]).Set(new_value, at);
+}
+
+template <std::integral V, typename Chunks>
+auto balance_function(balance_strategy_t strategy)
+    -> std::function<void(WSTM::WAtomic&, Chunks&)> {
+  switch (strategy) {
+    case balance_strategy_t::none:
+      return balance_none<V, Chunks>;
+    case balance_strategy_t::random:
+      return balance_random<V, Chunks>;
+    case balance_strategy_t::minmax:
+      return balance_minmax<V, Chunks>;
+    case balance_strategy_t::all:
+      return balance_all<V, Chunks>;
+    default:
+      assert(false);
+      return balance_none<V, Chunks>;
+  }
+}
+
+}  // namespace splittable::mrv
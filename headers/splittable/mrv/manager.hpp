@@ -1,7 +1,8 @@
 #pragma once
 
 #include <atomic>
-#include <execution>
+#include <condition_variable>
+#include <functional>
 #include <immer/map.hpp>
 #include <iostream>
 #include <memory>
@@ -10,33 +11,70 @@
 #include <unordered_map>
 
 #include "splittable/mrv/mrv.hpp"
+#include "splittable/utils/active_set.hpp"
+#include "splittable/utils/worker_pool.hpp"
 
 namespace splittable::mrv {
 
 class manager {
  private:
   inline static const auto ADJUST_INTERVAL = std::chrono::milliseconds(1000);
-  inline static const auto BALANCE_INTERVAL = std::chrono::milliseconds(100);
 
   using values_type = immer::map<uint, std::shared_ptr<mrv>>;
 
   values_type values;
   std::mutex values_mutex;  // needed to prevent data races on the assignment
+  // the objects used since the last adjust phase, which are the only ones it
+  // visits
+  utils::active_set active;
 
   std::chrono::nanoseconds total_adjust_time;
   uint64_t adjust_iterations;
   std::mutex adjust_time_mutex;
 
+  // ids of the objects that signalled an abort streak since the adjust
+  // worker last woke up; see `mrv::track_abort_streak`
+  std::vector<uint> growth_requests;
+  std::mutex growth_mutex;
+  std::condition_variable_any growth_condition;
+  uint64_t reactive_growths;
+
+  // the objects with skew signals since the balance worker last looked at
+  // them; see `mrv::record_skew`
+  utils::active_set skewed;
+
   std::chrono::nanoseconds total_balance_time;
   uint64_t balance_iterations;
   std::mutex balance_time_mutex;
 
+  // runs the adjust and balance phases; it must outlive the workers that use
+  // it. It is only created with the first registered object, so a program
+  // that never uses this kind of splittable does not start its threads
+  std::unique_ptr<utils::worker_pool> pool;
+  utils::worker_pool_options pool_options;
+  std::once_flag pool_created;
+  std::mutex pool_mutex;
+
   std::vector<std::jthread> workers;
 
   // the constructor is private to make this class a singleton
   manager();
   ~manager();
 
+  // runs `task` on the pool, once any current `configure_pool` is done; see
+  // `utils::worker_pool::run`
+  auto run_on_pool(size_t count, const std::function<void(size_t)>& task)
+      -> std::vector<size_t>;
+  // the objects in `ids` that are still registered
+  auto lookup(const std::vector<uint>& ids) -> std::vector<std::shared_ptr<mrv>>;
+  // grows the objects in `ids` that are still registered
+  auto react(const std::vector<uint>& ids) -> void;
+  // the objects in `objects` whose balance interval is over and whose chunks
+  // are uneven, the most skewed first; updates their schedules and queues the
+  // ones that are not due yet again
+  auto due_balances(const std::vector<std::shared_ptr<mrv>>& objects)
+      -> std::vector<std::shared_ptr<mrv>>;
+
  public:
   // prevent copy
   manager(manager const&) = delete;
@@ -44,11 +82,28 @@ class manager {
 
   auto static get_instance() -> manager&;
 
+  // sets the threads that adjust the objects; if they were started already,
+  // they are replaced once the current phase (if any) is done
+  auto configure_pool(utils::worker_pool_options options) -> void;
+
   auto register_mrv(std::shared_ptr<mrv> mrv) -> void;
   auto deregister_mrv(std::shared_ptr<mrv> mrv) -> void;
+  // adds the object with this id to the next adjust phase, unless `flag` says
+  // it is already there; see `mrv::mark_active`
+  auto activate(std::atomic_bool& flag, uint id) -> void;
+
+  // adds the object with this id to the next balance phase, unless `flag`
+  // says it is already there; see `mrv::record_skew`
+  auto queue_balance(std::atomic_bool& flag, uint id) -> void;
+
+  // wakes the adjust worker up to grow the object with this id now, instead
+  // of at the end of the current adjust interval
+  auto request_growth(uint id) -> void;
 
   auto get_avg_adjust_interval() -> std::chrono::nanoseconds;
   auto get_avg_balance_interval() -> std::chrono::nanoseconds;
+  // objects grown because of an abort streak since the last reset
+  auto get_reactive_growths() -> uint64_t;
 
   auto reset_global_stats() -> void;
 };
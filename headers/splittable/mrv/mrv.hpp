@@ -1,8 +1,10 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 
 #include "splittable/splittable.hpp"
+#include "splittable/utils/sharded_counters.hpp"
 
 namespace splittable::mrv {
 
@@ -11,32 +13,187 @@ struct status {
   uint64_t commits;
 };
 
+struct skew {
+  // chunks read by subs past the first one
+  uint64_t extra_scans;
+  // subs that did not find enough value
+  uint64_t failed_subs;
+};
+
 const double MIN_ABORT_RATE = 0.1;
 const double MAX_ABORT_RATE = 0.5;
 
 const uint MAX_NODES = 1024;
+
+// an instance asks the manager to grow it right away, instead of waiting for
+// the next adjust phase, when more than `MAX_ABORT_RATE` of its attempts within
+// `ABORT_STREAK_WINDOW` aborted; the rate is only trusted once the window has
+// seen `ABORT_STREAK_MIN_ATTEMPTS` attempts
+const uint ABORT_STREAK_MIN_ATTEMPTS = 32;
+// the rate sums every shard of the streak counters, so a thread only computes
+// it once every this many of its own aborts
+const uint ABORT_STREAK_CHECK_INTERVAL = 8;
+const auto ABORT_STREAK_WINDOW = std::chrono::milliseconds(5);
+
+// conflicts folding one add slot into the chunks may have before it is left
+// for the next adjust phase
+const uint FOLD_MAX_CONFLICTS = 8;
+// the same for moving value into the chunks a grow just added; the new chunks
+// are left empty until the next adjust phase if it keeps conflicting
+const uint SPREAD_MAX_CONFLICTS = 8;
+// and for merging the chunks a draining shrink removes; the shrink is undone
+// and tried again in the next adjust phase if it keeps conflicting
+const uint MERGE_MAX_CONFLICTS = 8;
+// and for the resizes of the layouts that publish a whole new array of chunks
+// in one transaction (`mrv_array`, `mrv_numa`)
+const uint RESIZE_MAX_CONFLICTS = 8;
+
+// slots of the per-instance status counters
+const size_t ABORTS_COUNTER = 0;
+const size_t ATTEMPTS_COUNTER = 1;
 const uint MIN_BALANCE_DIFF = 5;
 
+// slots of the per-instance skew counters
+const size_t EXTRA_SCANS_COUNTER = 0;
+const size_t FAILED_SUBS_COUNTER = 1;
+
+// each object has its own balance interval, which starts at `BALANCE_INTERVAL`
+// and is kept between these two; the scheduler looks for due objects every
+// `MIN_BALANCE_INTERVAL`
+const auto BALANCE_INTERVAL = std::chrono::milliseconds(100);
+const auto MIN_BALANCE_INTERVAL = std::chrono::milliseconds(10);
+const auto MAX_BALANCE_INTERVAL = std::chrono::milliseconds(1000);
+// spread of the chunks ((max - min) / mean) below which an object is not
+// balanced: its subs scan because it has little value, not because the value
+// is uneven
+const double MIN_BALANCE_SPREAD = 0.5;
+
+// `random` picks a uniformly random chunk on every operation; `cpu` maps the
+// current CPU to a home chunk, so the operations of one core keep hitting the
+// same cache line, and only goes elsewhere after a conflict or when the home
+// chunk runs out of value
+enum class chunk_selection_t { random, cpu };
+
+// `locked` removes chunks in one irrevocable transaction, which stops every
+// other transaction while it runs; `draining` first stops adding to them,
+// waits for the operations that could still pick them, and then moves their
+// value out in a regular transaction before unlinking them
+enum class removal_strategy_t { locked, draining };
+
+// `direct` adds to a chunk as soon as `add` is called; `commutative` buffers
+// the additions of a transaction and, right before it commits, adds them to a
+// slot of the calling thread that no other thread adds to, so concurrent
+// adders never share a variable. The slots are read by `read`, drained by the
+// subs that run out of value in the chunks and folded into the chunks on the
+// adjust phases
+enum class add_strategy_t { direct, commutative };
+
 class mrv : public splittable {
+ private:
+  static bool reactive_growth;
+
+  // attempts and aborts since `streak_start` (steady clock ticks), in the
+  // slots of the status counters; see `track_abort_streak`
+  utils::sharded_counters<2> streak_counters;
+  std::atomic<std::chrono::steady_clock::rep> streak_start{0};
+  // set from the signal until the manager grows the object, so a streak only
+  // queues it once
+  std::atomic_bool growth_requested{false};
+  // set while the object is in the manager's active set
+  std::atomic_bool active{false};
+
+  // see `record_skew`
+  utils::sharded_counters<2> skew_counters;
+  // set while the object is in the manager's skewed set
+  std::atomic_bool skewed{false};
+
  protected:
   static std::atomic_uint id_counter;
 
+  enum class adjust_t { keep, grow, shrink };
+
+  // what an adjust phase should do with a group of chunks, given its status
+  // since the last one; `abort_rate` is set along with it
+  auto static adjust_decision(status counters, double& abort_rate) -> adjust_t;
+  // how many of `size` chunks a shrink should merge away: half of them when
+  // there are no aborts, down to one as the rate gets close to
+  // `MIN_ABORT_RATE`; always leaves at least one chunk
+  auto static nodes_to_remove(size_t size, double abort_rate) -> size_t;
+
+  // counts aborts towards the current streak, and signals the manager when
+  // its abort rate goes over `MAX_ABORT_RATE`; the rate is only computed here,
+  // so commits just pay for counting their attempt
+  auto track_abort_streak(uint count) -> void;
+  // counts attempts towards the current streak
+  auto track_streak_attempts(uint count) -> void;
+  // counts a sub that read `scanned` chunks, and whether it found enough
+  // value; either sign of uneven chunks queues the object for the balance
+  // scheduler. A sub that takes its value from the first chunk it reads pays
+  // nothing for it
+  auto record_skew(size_t scanned, bool covered) -> void;
+
  public:
   // auto virtual static new_mrv(uint size) -> std::shared_ptr<mrv> = 0;
   // auto virtual static delete_mrv(std::shared_ptr<mrv>) -> void = 0;
 
   auto static thread_init() -> void;
   auto static global_init(uint num_threads) -> void;
+  // whether abort streaks grow the objects between adjust phases (the
+  // default); when disabled, only the periodic adjust phases resize them
+  auto static set_reactive_growth(bool enabled) -> void;
 
   auto virtual get_id() -> uint = 0;
+  // total number of chunks right now; it may change right after the call
+  auto virtual chunk_count() -> size_t = 0;
+  // whether an adjust phase that sees no use would still remove chunks
+  auto virtual shrinkable() -> bool;
+  // (max - min) / mean of the chunks, read without a transaction, so it is
+  // only a hint; 0 when the object has no value or a single chunk
+  auto virtual chunk_spread() -> double = 0;
 
   auto virtual add_aborts(uint count) -> void = 0;
-  auto virtual add_commits(uint count) -> void = 0;
+  // transactions are counted when they first touch the object instead of
+  // after the commit, so no `After` callback is needed; commits are then
+  // attempts minus aborts
+  auto virtual add_attempts(uint count) -> void = 0;
   auto virtual fetch_and_reset_status() -> status = 0;
 
   auto virtual add_nodes(double abort_rate) -> void = 0;
-  auto virtual remove_node() -> void = 0;
+  auto virtual remove_nodes(double abort_rate) -> void = 0;
   auto virtual balance() -> void = 0;
+
+  // called by the manager on every adjust phase; by default it grows or
+  // shrinks the object based on the abort rate since the last call, but types
+  // with more than one group of chunks can size each of them on their own
+  auto virtual adjust() -> void;
+  // called by the manager after the object signalled an abort streak; grows
+  // it as if the last adjust phase had seen an abort rate of `MAX_ABORT_RATE`
+  auto virtual react() -> void;
+  // lets a new streak signal the manager again, without growing the object;
+  // for a request the manager had no budget for
+  auto drop_growth_request() -> void;
+  // queues the object for the next adjust phase; called on every counted
+  // attempt, but only the first one after a phase reaches the manager
+  auto mark_active() -> void;
+  // called by the manager right before it adjusts the object, so that any use
+  // from then on queues it again
+  auto clear_active() -> void;
+
+  // the same two for the balance scheduler
+  auto mark_skewed() -> void;
+  auto clear_skewed() -> void;
+  // skew signals since the last call
+  auto fetch_and_reset_skew() -> skew;
+
+  // only used by the manager's balance worker
+  struct {
+    std::chrono::steady_clock::time_point next{};
+    std::chrono::steady_clock::duration interval = BALANCE_INTERVAL;
+    // skew signals since the last balance
+    uint64_t pending = 0;
+    // whether the object was already skewed again before `next`
+    bool waited = false;
+  } balance_schedule;
 };
 
 }  // namespace splittable::mrv
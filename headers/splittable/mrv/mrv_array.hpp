@@ -0,0 +1,102 @@
+#pragma once
+
+#include <wstm/stm.h>
+
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "splittable/mrv/balance.hpp"
+#include "splittable/mrv/manager.hpp"
+#include "splittable/mrv/mrv.hpp"
+#include "splittable/utils/delta_buffer.hpp"
+#include "splittable/utils/random.hpp"
+#include "splittable/utils/sharded_counters.hpp"
+
+namespace splittable::mrv {
+
+template <std::integral V>
+using chunk_array_t = std::vector<WSTM::WVar<V>>;
+
+/// @brief MRV whose chunk handles are stored contiguously in one array,
+/// instead of in a persistent vector of `shared_ptr`s like in
+/// `mrv_flex_vector`. A `WVar` is itself a handle to heap-allocated state, so
+/// reading a chunk still follows its pointers; what the layout saves is the
+/// extra indirection and the tree walk to find the handle. The array is never
+/// changed in place: growing or shrinking builds a new one and publishes it
+/// through the `chunks` WVar, so any transaction still using the old array
+/// conflicts and retries.
+template <std::integral V>
+class mrv_array final : public mrv,
+                        public std::enable_shared_from_this<mrv_array<V>> {
+ public:
+  using value_type = V;
+
+ private:
+  // aborts and attempts, see `ABORTS_COUNTER` and `ATTEMPTS_COUNTER`
+  utils::sharded_counters<2> status_counters;
+
+  uint id;
+  WSTM::WVar<std::shared_ptr<chunk_array_t<V>>> chunks;
+  static std::function<void(WSTM::WAtomic&, chunk_array_t<V>&)>
+      balance_strategy;
+
+  utils::delta_buffer<V> deltas;
+  // set once the current transaction is counted in `status_counters`
+  WSTM::WTransactionLocalFlag status_tracked;
+
+  // counts the transaction for the abort rate, once per transaction
+  auto setup_status_tracking(WSTM::WAtomic& at) -> void;
+
+  auto add_to_chunks(WSTM::WAtomic& at, V value) -> void;
+  // subtracts from the buffered deltas first (if enabled), then from chunks
+  auto apply_sub(WSTM::WAtomic& at, V value) -> bool;
+  auto sub_from_chunks(WSTM::WAtomic& at, V value) -> bool;
+  // publishes a copy of the current chunks with `size` entries; chunks that
+  // are dropped have their value moved to the ones that are kept
+  auto resize(uint size) -> void;
+
+ public:
+  // TODO: this is not private because of make_shared, need to revise that later
+  mrv_array(V value);
+
+  auto static new_instance(V value) -> std::shared_ptr<mrv_array>;
+  auto static delete_instance(std::shared_ptr<mrv_array>) -> void;
+
+  auto static set_balance_strategy(balance_strategy_t strategy) -> void;
+
+  auto get_id() -> uint;
+  auto chunk_count() -> size_t;
+  auto chunk_spread() -> double;
+
+  auto static get_avg_adjust_interval() -> std::chrono::nanoseconds;
+  auto static get_avg_balance_interval() -> std::chrono::nanoseconds;
+  auto static get_avg_phase_interval() -> std::chrono::nanoseconds;
+  auto static reset_global_stats() -> void;
+
+  auto add_aborts(uint count) -> void;
+  auto add_attempts(uint count) -> void;
+  auto fetch_and_reset_status() -> status;
+
+  auto read(WSTM::WAtomic& at) -> V;
+  // sum of the chunks as last committed, without joining a transaction; each
+  // chunk is read on its own, so the sum may mix commits and is only meant
+  // for monitoring
+  auto inconsistent_read(WSTM::WInconsistent& inc) -> V;
+  auto add(WSTM::WAtomic& at, V value) -> void;
+  auto sub(WSTM::WAtomic& at, V value) -> void;
+  // `sub` that returns false on insufficient value instead of throwing
+  auto try_sub(WSTM::WAtomic& at, V value) -> bool;
+  // sets up the tracking the operations above do for the transaction; see
+  // `apply_batch`
+  auto track(WSTM::WAtomic& at) -> void;
+
+  auto add_nodes(double abort_rate) -> void;
+  auto remove_nodes(double abort_rate) -> void;
+  auto balance() -> void;
+};
+
+}  // namespace splittable::mrv
@@ -2,11 +2,15 @@
 
 #include <wstm/stm.h>
 
+#include <array>
 #include <atomic>
+#include <concepts>
+#include <cstdint>
 #include <immer/algorithm.hpp>
 #include <immer/flex_vector.hpp>
 #include <immer/flex_vector_transient.hpp>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <new>
@@ -14,37 +18,137 @@
 #include <queue>
 #include <vector>
 
+#include "splittable/mrv/balance.hpp"
 #include "splittable/mrv/manager.hpp"
 #include "splittable/mrv/mrv.hpp"
+#include "splittable/utils/delta_buffer.hpp"
+#include "splittable/utils/epoch.hpp"
+#include "splittable/utils/occupancy_bitmap.hpp"
 #include "splittable/utils/random.hpp"
+#include "splittable/utils/sharded_counters.hpp"
 
 namespace splittable::mrv {
 
-using chunk_t = WSTM::WVar<uint>;
-using chunks_t = immer::flex_vector<std::shared_ptr<chunk_t>>;
+template <std::integral V>
+using chunk_t = WSTM::WVar<V>;
+template <std::integral V>
+using chunks_t = immer::flex_vector<std::shared_ptr<chunk_t<V>>>;
+
+template <std::integral V>
+struct directory_t {
+  chunks_t<V> chunks;
+  // operations only pick chunks before this index; the ones after it are
+  // being removed, so they are still read and drained, but not added to
+  size_t active;
+};
 
-enum class balance_strategy_t { none, random, minmax, all };
+template <std::integral V>
+class mrv_flex_vector final
+    : public mrv,
+      public std::enable_shared_from_this<mrv_flex_vector<V>> {
+ public:
+  using value_type = V;
 
-class mrv_flex_vector : public mrv,
-                        public std::enable_shared_from_this<mrv_flex_vector> {
  private:
-  // 16 bits for aborts, 16 bits for commits
-  std::atomic_uint32_t status_counters;
+  // chunks per partial sum, when `read_aggregation` is enabled
+  static constexpr size_t GROUP_SIZE = 16;
+
+  // aborts and attempts, see `ABORTS_COUNTER` and `ATTEMPTS_COUNTER`
+  utils::sharded_counters<2> status_counters;
 
   uint id;
-  std::atomic<std::shared_ptr<chunks_t>> chunks;
-  static std::function<void(WSTM::WAtomic&, chunks_t)> balance_strategy;
+  // published with a plain atomic pointer and reclaimed through epochs (see
+  // `utils::epoch_guard`), so that loading it on every operation does not
+  // touch a shared reference count
+  std::atomic<directory_t<V>*> directory;
+  // which chunks hold value, so that `sub` can skip the empty ones
+  utils::occupancy_bitmap<MAX_NODES> occupied;
+  static std::function<void(WSTM::WAtomic&, chunks_t<V>&)> balance_strategy;
+  static add_strategy_t add_strategy;
+  static chunk_selection_t chunk_selection;
+  static removal_strategy_t removal_strategy;
+  static bool read_aggregation;
+  // set when a transaction of this thread aborted, so that its next pick
+  // moves away from the home chunk
+  static thread_local bool chunk_conflict;
+
+  // one per hardware thread, see `add_strategy_t::commutative`; empty unless
+  // that strategy was set when the object was created. The vector itself
+  // never changes after construction
+  std::vector<chunk_t<V>> add_slots;
+
+  utils::delta_buffer<V> deltas;
+  // set once the current transaction is counted in `status_counters`
+  WSTM::WTransactionLocalFlag status_tracked;
+  // sum of each group of `GROUP_SIZE` chunks, kept in the same transactions
+  // that change the chunks; empty unless `read_aggregation` was enabled when
+  // the object was created
+  std::vector<WSTM::WVar<V>> group_sums;
+  // first chunk still waiting for its share of the value after a grow whose
+  // spread kept conflicting, or 0; only used by the manager
+  size_t unspread_from = 0;
+
+  // counts the transaction for the abort rate, once per transaction
+  auto setup_status_tracking(WSTM::WAtomic& at) -> void;
+  // index of the chunk an operation should start at
+  auto static pick_chunk(size_t size) -> size_t;
+  // whether additions go through `deltas` instead of the chunks
+  auto buffers_deltas() -> bool;
+  // index of the calling thread's add slot, picked round-robin on first use
+  auto static local_slot() -> size_t;
+  // applies the additions buffered by a transaction, right before it commits
+  auto commit_add(WSTM::WAtomic& at, V value) -> void;
+  auto add_to_chunks(WSTM::WAtomic& at, V value) -> void;
+  // subtracts from the buffered deltas first (if enabled), then from chunks
+  auto apply_sub(WSTM::WAtomic& at, V value) -> bool;
+  auto sub_from_chunks(WSTM::WAtomic& at, V value) -> bool;
+  // takes `value` from the add slots, starting at the caller's; nothing is
+  // taken if they do not hold enough
+  auto sub_from_slots(WSTM::WAtomic& at, V value) -> bool;
+  // moves the value of every add slot into a chunk, each in a transaction of
+  // its own; one that keeps conflicting is left for the next phase
+  auto fold_slots() -> void;
+  // applies a change of a chunk's value to its group sum, if there are any
+  auto add_to_group(WSTM::WAtomic& at, size_t index, V value) -> void;
+  auto sub_from_group(WSTM::WAtomic& at, size_t index, V value) -> void;
+  // recomputes every group sum from the chunks
+  auto refresh_groups(WSTM::WAtomic& at, chunks_t<V>& chunks) -> void;
+  // moves value from the chunks before `from` into the ones after it, which
+  // were just added, so that they do not start empty
+  auto spread_value(WSTM::WAtomic& at, chunks_t<V>& chunks, size_t from)
+      -> void;
+  // runs `spread_value` over the current chunks with a conflict limit, so a
+  // hot object cannot keep the manager retrying; on failure it is left for
+  // the next adjust phase
+  auto try_spread(size_t from) -> void;
+  // moves the value of the chunks from `new_size` on into `absorbers` (one per
+  // removed chunk) and zeroes them
+  auto merge_chunks(WSTM::WAtomic& at, chunks_t<V>& chunks, size_t new_size,
+                    const std::vector<size_t>& absorbers) -> void;
 
  public:
   // TODO: this is not private because of make_shared, need to revise that later
-  mrv_flex_vector(uint value);
+  mrv_flex_vector(V value);
+  ~mrv_flex_vector();
 
-  auto static new_instance(uint value) -> std::shared_ptr<mrv_flex_vector>;
+  auto static new_instance(V value) -> std::shared_ptr<mrv_flex_vector>;
   auto static delete_instance(std::shared_ptr<mrv_flex_vector>) -> void;
 
   auto static set_balance_strategy(balance_strategy_t strategy) -> void;
+  auto static set_chunk_selection(chunk_selection_t selection) -> void;
+  auto static set_removal_strategy(removal_strategy_t strategy) -> void;
+  // applies to the objects created from then on
+  auto static set_add_strategy(add_strategy_t strategy) -> void;
+  // makes objects created from now on keep partial sums of their chunks, so
+  // that reads go over one variable per `GROUP_SIZE` chunks instead of every
+  // chunk; writers to chunks in the same group then conflict on its sum
+  auto static set_read_aggregation(bool enabled) -> void;
 
   auto get_id() -> uint;
+  // number of chunks right now, only meant for monitoring
+  auto chunk_count() -> size_t;
+  // over the chunks that are not being removed
+  auto chunk_spread() -> double;
 
   auto static get_avg_adjust_interval() -> std::chrono::nanoseconds;
   auto static get_avg_balance_interval() -> std::chrono::nanoseconds;
@@ -52,18 +156,28 @@ class mrv_flex_vector : public mrv,
   auto static reset_global_stats() -> void;
 
   auto add_aborts(uint count) -> void;
-  auto add_commits(uint count) -> void;
+  auto add_attempts(uint count) -> void;
   auto fetch_and_reset_status() -> status;
   auto fetch_total_status() -> status;
 
-  auto read(WSTM::WAtomic& at) -> uint;
-  // auto inconsistent_read(WSTM::WInconsistent& inc) -> uint;
-  auto add(WSTM::WAtomic& at, uint value) -> void;
-  auto sub(WSTM::WAtomic& at, uint value) -> void;
+  auto read(WSTM::WAtomic& at) -> V;
+  // sum of the chunks and add slots as last committed, without joining a
+  // transaction; each is read on its own, so the sum may mix commits and is
+  // only meant for monitoring
+  auto inconsistent_read(WSTM::WInconsistent& inc) -> V;
+  auto add(WSTM::WAtomic& at, V value) -> void;
+  auto sub(WSTM::WAtomic& at, V value) -> void;
+  // `sub` that returns false on insufficient value instead of throwing
+  auto try_sub(WSTM::WAtomic& at, V value) -> bool;
+  // sets up the tracking the operations above do for the transaction; see
+  // `apply_batch`
+  auto track(WSTM::WAtomic& at) -> void;
 
   auto add_nodes(double abort_rate) -> void;
-  auto remove_node() -> void;
+  auto remove_nodes(double abort_rate) -> void;
   auto balance() -> void;
+  // also folds the add slots into the chunks
+  auto adjust() -> void;
 };
 
 }  // namespace splittable::mrv
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <wstm/stm.h>
+
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "splittable/mrv/balance.hpp"
+#include "splittable/mrv/manager.hpp"
+#include "splittable/mrv/mrv.hpp"
+#include "splittable/mrv/mrv_array.hpp"
+#include "splittable/utils/delta_buffer.hpp"
+#include "splittable/utils/numa.hpp"
+#include "splittable/utils/random.hpp"
+#include "splittable/utils/sharded_counters.hpp"
+
+namespace splittable::mrv {
+
+/// @brief MRV with one group of chunks per NUMA node. Each group is laid out
+/// like `mrv_array` and allocated from a thread running on its node, so its
+/// memory is local to it. Operations start on the group of the node they run
+/// on and only reach the others when a `sub` needs more value than the local
+/// group has. Balancing is mostly done inside each group; value only moves
+/// between nodes once every `CROSS_NODE_BALANCE_PERIOD` rounds. Each group is
+/// also sized on its own, based on the aborts of the transactions started on
+/// its node.
+template <std::integral V>
+class mrv_numa final : public mrv,
+                       public std::enable_shared_from_this<mrv_numa<V>> {
+ public:
+  using value_type = V;
+
+ private:
+  static constexpr uint CROSS_NODE_BALANCE_PERIOD = 10;
+
+  struct node_group {
+    // aborts and attempts, see `ABORTS_COUNTER` and `ATTEMPTS_COUNTER`
+    utils::sharded_counters<2> status_counters;
+    WSTM::WVar<std::shared_ptr<chunk_array_t<V>>> chunks;
+  };
+
+  uint id;
+  // one per node; the vector itself never changes after construction
+  std::vector<std::unique_ptr<node_group>> nodes;
+  std::atomic_uint balance_rounds;
+  static std::function<void(WSTM::WAtomic&, chunk_array_t<V>&)>
+      balance_strategy;
+
+  utils::delta_buffer<V> deltas;
+  // set once the current transaction is counted in `status_counters`
+  WSTM::WTransactionLocalFlag status_tracked;
+
+  // chunks each group can have, so the whole object stays under `MAX_NODES`
+  auto static max_group_size() -> size_t;
+  // counts the transaction for the abort rate of the node it runs on, once
+  // per transaction
+  auto setup_status_tracking(WSTM::WAtomic& at) -> void;
+  auto fetch_and_reset_status(uint node) -> status;
+
+  auto add_to_chunks(WSTM::WAtomic& at, V value) -> void;
+  // subtracts from the buffered deltas first (if enabled), then from chunks
+  auto apply_sub(WSTM::WAtomic& at, V value) -> bool;
+  auto sub_from_chunks(WSTM::WAtomic& at, V value) -> bool;
+
+  // publishes a copy of the chunks of `node` with `size` entries, allocated on
+  // that node; chunks that are dropped have their value moved to the ones that
+  // are kept
+  auto resize(uint node, size_t size) -> void;
+  auto add_nodes(uint node, double abort_rate) -> void;
+  auto remove_nodes(uint node, double abort_rate) -> void;
+  // moves value from the richest node to the poorest one
+  auto balance_nodes(WSTM::WAtomic& at) -> void;
+
+ public:
+  // TODO: this is not private because of make_shared, need to revise that later
+  mrv_numa(V value);
+
+  auto static new_instance(V value) -> std::shared_ptr<mrv_numa>;
+  auto static delete_instance(std::shared_ptr<mrv_numa>) -> void;
+
+  auto static set_balance_strategy(balance_strategy_t strategy) -> void;
+
+  auto get_id() -> uint;
+  // over every node
+  auto chunk_count() -> size_t;
+  // each node keeps at least one chunk
+  auto shrinkable() -> bool;
+  // the largest spread of any node, since most balancing is done inside each
+  auto chunk_spread() -> double;
+
+  auto static get_avg_adjust_interval() -> std::chrono::nanoseconds;
+  auto static get_avg_balance_interval() -> std::chrono::nanoseconds;
+  auto static get_avg_phase_interval() -> std::chrono::nanoseconds;
+  auto static reset_global_stats() -> void;
+
+  // these two count for the node the caller is running on
+  auto add_aborts(uint count) -> void;
+  auto add_attempts(uint count) -> void;
+  // the status of every node added up
+  auto fetch_and_reset_status() -> status;
+
+  auto read(WSTM::WAtomic& at) -> V;
+  // sum of the chunks of every node as last committed, without joining a
+  // transaction; may mix commits, so it is only meant for monitoring
+  auto inconsistent_read(WSTM::WInconsistent& inc) -> V;
+  auto add(WSTM::WAtomic& at, V value) -> void;
+  auto sub(WSTM::WAtomic& at, V value) -> void;
+  // `sub` that returns false on insufficient value instead of throwing
+  auto try_sub(WSTM::WAtomic& at, V value) -> bool;
+  // sets up the tracking the operations above do for the transaction; see
+  // `apply_batch`
+  auto track(WSTM::WAtomic& at) -> void;
+
+  // these two apply to every node
+  auto add_nodes(double abort_rate) -> void;
+  auto remove_nodes(double abort_rate) -> void;
+  auto balance() -> void;
+  auto adjust() -> void;
+};
+
+}  // namespace splittable::mrv
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <wstm/stm.h>
+
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <execution>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace splittable::mrv {
+
+// The balance strategies are shared by every MRV layout, so they take the
+// chunk container as a template parameter and go through `as_chunk` to reach
+// each chunk, whether the container holds pointers to them or the chunks
+// themselves.
+
+template <std::integral V>
+auto as_chunk(const std::shared_ptr<WSTM::WVar<V>>& chunk) -> WSTM::WVar<V>& {
+  return *chunk;
+}
+
+template <std::integral V>
+auto as_chunk(WSTM::WVar<V>& chunk) -> WSTM::WVar<V>& {
+  return chunk;
+}
+
+/// @brief Copies the value of every chunk into a contiguous buffer, under a
+/// single read lock, so that the kernels below can run over plain memory. The
+/// buffer is per thread and reused, so taking a snapshot does not allocate
+/// once it has grown to the largest object seen; it is only valid until the
+/// next snapshot on the same thread.
+template <std::integral V, typename Chunks>
+auto snapshot(WSTM::WAtomic& at, Chunks& chunks) -> std::span<const V> {
+  thread_local std::vector<V> buffer;
+
+  auto size = chunks.size();
+  buffer.resize(size);
+  {
+    WSTM::WReadLockGuard<WSTM::WAtomic> lock(at);
+    for (auto i = 0u; i < size; ++i) {
+      buffer[i] = as_chunk(chunks[i]).Get(at);
+    }
+  }
+
+  return {buffer.data(), size};
+}
+
+// 64 bits, like the strategies always summed into, so that the total of many
+// 32-bit chunks does not wrap; signed when `V` is, so that negative chunks add
+// up and divide as such
+template <std::integral V>
+using sum_t = std::conditional_t<std::is_signed_v<V>, int64_t, uint64_t>;
+
+template <std::integral V>
+auto snapshot_sum(std::span<const V> values) -> sum_t<V> {
+  return std::reduce(std::execution::unseq, values.begin(), values.end(),
+                     sum_t<V>{0});
+}
+
+// indexes of the first smallest and the last largest value
+template <std::integral V>
+auto snapshot_minmax(std::span<const V> values) -> std::pair<size_t, size_t> {
+  auto [min, max] = std::minmax_element(std::execution::unseq, values.begin(),
+                                        values.end());
+  return {min - values.begin(), max - values.begin()};
+}
+
+/// @brief (max - min) / mean of the first `size` chunks, read one by one with
+/// `GetInconsistent`, so the values may come from different commits; it is
+/// only meant to tell whether balancing is worth a transaction. 0 with fewer
+/// than two chunks or no value at all.
+template <std::integral V, typename Chunks>
+auto inconsistent_spread(WSTM::WInconsistent& inc, Chunks& chunks, size_t size)
+    -> double {
+  if (size < 2) {
+    return 0.0;
+  }
+
+  auto first = as_chunk(chunks[0]).GetInconsistent(inc);
+  V min = first;
+  V max = first;
+  sum_t<V> sum = 0;
+
+  for (auto i = 0u; i < size; ++i) {
+    auto value = as_chunk(chunks[i]).GetInconsistent(inc);
+    min = std::min(min, value);
+    max = std::max(max, value);
+    sum += value;
+  }
+
+  if (sum <= 0) {
+    return 0.0;
+  }
+
+  return static_cast<double>(max - min) / (static_cast<double>(sum) / size);
+}
+
+/// @brief Indexes of the `k` smallest values followed by the ones of the `k`
+/// largest, in no particular order within each half. Expects `k + k` to be at
+/// most the number of values, so the two halves never share an index.
+template <std::integral V>
+auto snapshot_top_k(std::span<const V> values, size_t k)
+    -> std::vector<uint> {
+  std::vector<uint> indexes(values.size());
+  std::iota(indexes.begin(), indexes.end(), 0u);
+
+  auto by_value = [&](uint a, uint b) { return values[a] < values[b]; };
+
+  std::nth_element(indexes.begin(), indexes.begin() + k, indexes.end(),
+                   by_value);
+  std::nth_element(indexes.begin() + k, indexes.end() - k, indexes.end(),
+                   by_value);
+
+  // moves the largest ones right after the smallest
+  indexes.erase(indexes.begin() + k, indexes.end() - k);
+  return indexes;
+}
+
+}  // namespace splittable::mrv
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <chrono>
-#include <execution>
+#include <functional>
 #include <immer/map.hpp>
 #include <iostream>
 #include <memory>
@@ -10,6 +10,8 @@
 #include <unordered_map>
 
 #include "splittable/pr/pr.hpp"
+#include "splittable/utils/active_set.hpp"
+#include "splittable/utils/worker_pool.hpp"
 
 namespace splittable::pr {
 
@@ -21,17 +23,35 @@ class manager {
 
   values_type values;
   std::mutex values_mutex;  // needed to prevent data races on the assignment
+  // the objects used since the last phase, which are the only ones it visits;
+  // every transition needs aborts, waiting readers or failed subs, so each of
+  // those signals queues the object, not only the attempt that comes before
+  // it: a phase may take the object in between and miss the signal
+  utils::active_set active;
 
   std::chrono::nanoseconds total_phase_time;
   uint64_t phase_iterations;
   std::mutex phase_time_mutex;
 
+  // runs the phases; it must outlive the workers that use it. See
+  // `mrv::manager::pool`
+  std::unique_ptr<utils::worker_pool> pool;
+  utils::worker_pool_options pool_options;
+  std::once_flag pool_created;
+  std::mutex pool_mutex;
+
   std::vector<std::jthread> workers;
 
   // the constructor is private to make this class a singleton
   manager();
   ~manager();
 
+  // see `mrv::manager::run_on_pool`
+  auto run_on_pool(size_t count, const std::function<void(size_t)>& task)
+      -> std::vector<size_t>;
+  // the objects in `ids` that are still registered
+  auto lookup(const std::vector<uint>& ids) -> std::vector<std::shared_ptr<pr>>;
+
  public:
   // prevent copy
   manager(manager const&) = delete;
@@ -39,8 +59,13 @@ class manager {
 
   auto static get_instance() -> manager&;
 
+  // see `mrv::manager::configure_pool`
+  auto configure_pool(utils::worker_pool_options options) -> void;
+
   auto register_pr(std::shared_ptr<pr> pr) -> void;
   auto deregister_pr(std::shared_ptr<pr> pr) -> void;
+  // see `mrv::manager::activate`
+  auto activate(std::atomic_bool& flag, uint id) -> void;
 
   auto get_avg_phase_interval() -> std::chrono::nanoseconds;
 
@@ -6,6 +6,12 @@
 
 namespace splittable::pr {
 
+// slots of the per-instance status counters
+const size_t ABORTS_COUNTER = 0;
+const size_t ABORTS_FOR_NO_STOCK_COUNTER = 1;
+const size_t ATTEMPTS_COUNTER = 2;
+const size_t WAITING_COUNTER = 3;
+
 struct status {
   uint64_t aborts;
   uint64_t aborts_for_no_stock;
@@ -14,6 +20,10 @@ struct status {
 };
 
 class pr : public splittable {
+ private:
+  // set while the object is in the manager's active set
+  std::atomic_bool active{false};
+
  protected:
   static std::atomic_uint id_counter;
 
@@ -30,13 +40,19 @@ class pr : public splittable {
   auto virtual add_aborts(uint count) -> void = 0;
   auto virtual add_aborts_for_no_stock(uint count) -> void = 0;
   auto virtual add_waiting(uint count) -> void = 0;
-  auto virtual add_commits(uint count) -> void = 0;
+  // see `mrv::add_attempts`
+  auto virtual add_attempts(uint count) -> void = 0;
   auto virtual fetch_and_reset_status() -> status = 0;
 
   auto static register_thread() -> void;
   // auto unregister_thread() -> void = 0;
   auto static set_num_threads(uint num) -> void;
 
+  // queues the object for the next phase; see `mrv::mark_active`
+  auto mark_active() -> void;
+  // called by the manager right before it visits the object
+  auto clear_active() -> void;
+
   auto virtual try_transition(double abort_rate, uint waiting,
                               uint aborts_for_no_stock) -> void = 0;
   auto virtual split(WSTM::WAtomic& at) -> void = 0;
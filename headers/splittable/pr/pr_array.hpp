@@ -4,6 +4,8 @@
 
 #include <algorithm>
 #include <atomic>
+#include <concepts>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <new>
@@ -11,22 +13,29 @@
 
 #include "splittable/pr/manager.hpp"
 #include "splittable/pr/pr.hpp"
+#include "splittable/utils/delta_buffer.hpp"
+#include "splittable/utils/sharded_counters.hpp"
 
 namespace splittable::pr {
 
-class pr_array : public pr, public std::enable_shared_from_this<pr_array> {
+template <std::integral V>
+class pr_array final : public pr,
+                       public std::enable_shared_from_this<pr_array<V>> {
+ public:
+  using value_type = V;
+
  private:
-  using chunk_t = WSTM::WVar<uint>;
+  using chunk_t = WSTM::WVar<V>;
 
-  using single_t = uint;
+  using single_t = V;
   // each of the values needs to be a WVar, I think, to allow transactions to
   // rollback if needed. if they're not WVars, even if each thread only
   // accesses its chunk, there could be some data inconsistency
   using splitted_t = std::vector<chunk_t>;
 
-  // 16 bits for each of the counters: aborts, aborts_for_no_stock, commits,
-  // waiting
-  std::atomic_uint64_t status_counters;
+  // aborts, aborts_for_no_stock, attempts and waiting, see `ABORTS_COUNTER`
+  // and the others
+  utils::sharded_counters<4> status_counters;
 
   uint id;
 
@@ -37,13 +46,21 @@ class pr_array : public pr, public std::enable_shared_from_this<pr_array> {
 
   WSTM::WVar<bool> is_splitted;
 
+  utils::delta_buffer<V> deltas;
+  // set once the current transaction is counted in `status_counters`
+  WSTM::WTransactionLocalFlag status_tracked;
+
+  // counts the transaction for the abort rate, once per transaction
   auto setup_status_tracking(WSTM::WAtomic& at) -> void;
 
+  auto add_to_value(WSTM::WAtomic& at, V value) -> void;
+  auto sub_from_value(WSTM::WAtomic& at, V value) -> bool;
+
  public:
   // TODO: this is not private because of make_shared, need to revise that later
-  pr_array(uint value);
+  pr_array(V value);
 
-  auto static new_instance(uint value) -> std::shared_ptr<pr_array>;
+  auto static new_instance(V value) -> std::shared_ptr<pr_array>;
   auto static delete_instance(std::shared_ptr<pr_array>) -> void;
 
   auto get_id() -> uint;
@@ -56,13 +73,21 @@ class pr_array : public pr, public std::enable_shared_from_this<pr_array> {
   auto add_aborts(uint count) -> void;
   auto add_aborts_for_no_stock(uint count) -> void;
   auto add_waiting(uint count) -> void;
-  auto add_commits(uint count) -> void;
+  auto add_attempts(uint count) -> void;
   auto fetch_and_reset_status() -> status;
 
-  auto read(WSTM::WAtomic& at) -> uint;
-  // auto inconsistent_read(WSTM::WInconsistent& inc) -> uint;
-  auto add(WSTM::WAtomic& at, uint value) -> void;
-  auto sub(WSTM::WAtomic& at, uint value) -> void;
+  auto read(WSTM::WAtomic& at) -> V;
+  // last committed value, without joining a transaction; while split, the
+  // chunks are summed as they are instead of waiting for a reconcile like
+  // `read`, so the sum may mix commits and is only meant for monitoring
+  auto inconsistent_read(WSTM::WInconsistent& inc) -> V;
+  auto add(WSTM::WAtomic& at, V value) -> void;
+  auto sub(WSTM::WAtomic& at, V value) -> void;
+  // `sub` that returns false on insufficient value instead of throwing
+  auto try_sub(WSTM::WAtomic& at, V value) -> bool;
+  // sets up the tracking the operations above do for the transaction; see
+  // `apply_batch`
+  auto track(WSTM::WAtomic& at) -> void;
 
   auto try_transition(double abort_rate, uint waiting, uint aborts_for_no_stock)
       -> void;
@@ -2,22 +2,34 @@
 
 #include <wstm/stm.h>
 
+#include <concepts>
+#include <cstdint>
+
 #include "splittable/splittable.hpp"
+#include "splittable/utils/delta_buffer.hpp"
 
 namespace splittable::single {
 
-class single : public splittable {
+template <std::integral V>
+class single final : public splittable {
+ public:
+  using value_type = V;
+
  private:
-  WSTM::WVar<uint> value;
+  WSTM::WVar<V> value;
+  utils::delta_buffer<V> deltas;
+
+  auto add_to_value(WSTM::WAtomic& at, V value) -> void;
+  auto sub_from_value(WSTM::WAtomic& at, V value) -> bool;
 
  public:
   // TODO: this is not private because of make_shared, need to revise that later
-  single(uint value);
+  single(V value);
 
   auto static thread_init() -> void;
   auto static global_init(uint num_threads) -> void;
 
-  auto static new_instance(uint value) -> std::shared_ptr<single>;
+  auto static new_instance(V value) -> std::shared_ptr<single>;
   auto static delete_instance(std::shared_ptr<single>) -> void;
 
   auto static get_avg_adjust_interval() -> std::chrono::nanoseconds;
@@ -25,10 +37,17 @@ class single : public splittable {
   auto static get_avg_phase_interval() -> std::chrono::nanoseconds;
   auto static reset_global_stats() -> void;
 
-  auto read(WSTM::WAtomic& at) -> uint;
-  // auto inconsistent_read(WSTM::WInconsistent& inc) -> uint;
-  auto add(WSTM::WAtomic& at, uint value) -> void;
-  auto sub(WSTM::WAtomic& at, uint value) -> void;
+  auto read(WSTM::WAtomic& at) -> V;
+  // last committed value, without joining a transaction; deltas buffered by
+  // running transactions are not part of it
+  auto inconsistent_read(WSTM::WInconsistent& inc) -> V;
+  auto add(WSTM::WAtomic& at, V value) -> void;
+  auto sub(WSTM::WAtomic& at, V value) -> void;
+  // `sub` that returns false on insufficient value instead of throwing
+  auto try_sub(WSTM::WAtomic& at, V value) -> bool;
+  // sets up the tracking the operations above do for the transaction; see
+  // `apply_batch`
+  auto track(WSTM::WAtomic& at) -> void;
 };
 
-}  // namespace splittable::single
\ No newline at end of file
+}  // namespace splittable::single
@@ -2,14 +2,19 @@
 
 #include <wstm/stm.h>
 
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
 #include <exception>
 #include <memory>
+#include <new>
 #include <string>
 
 namespace splittable {
 
-enum class error { insufficient_value, other };
+enum class error { insufficient_value, overflow, other };
 
 struct exception : public std::exception {
   error err;
@@ -21,6 +26,8 @@ struct exception : public std::exception {
   //   switch (err) {
   //     case error::insufficient_value:
   //       return "could not perform the subtraction";
+  //     case error::overflow:
+  //       return "could not perform the addition";
   //     case error::other:
   //     default:
   //       return "unknown error";
@@ -28,27 +35,90 @@ struct exception : public std::exception {
   // }
 };
 
+/// @brief Checks if `current + value` wraps around the counter type, so that
+/// the addition can be refused instead of silently corrupting the value.
+template <std::integral V>
+auto constexpr would_overflow(V current, V value) -> bool {
+  V result;
+  return __builtin_add_overflow(current, value, &result);
+}
+
 struct status {
   uint64_t aborts;
   uint64_t commits;
 };
 
+/// @brief Shared bookkeeping for every splittable type. The operations
+/// themselves (read/add/sub) are not virtual: callers that know the concrete
+/// type should constrain it with `splittable_type` so that the calls can be
+/// inlined, and the few places that need runtime polymorphism can use
+/// `any_splittable`.
 class splittable {
  private:
-  static std::atomic_uint64_t total_aborts;
-  static std::atomic_uint64_t total_commits;
+  struct alignas(std::hardware_destructive_interference_size) stats_shard {
+    std::atomic_uint64_t aborts;
+    std::atomic_uint64_t commits;
+  };
+
+  // the global stats are split per thread, each in its own cache line, so that
+  // every commit/abort does not hit the same memory; they are only summed when
+  // read. Threads past `MAX_STATS_SHARDS` share shards, which is still correct
+  static constexpr uint MAX_STATS_SHARDS = 256;
+  static std::array<stats_shard, MAX_STATS_SHARDS> stats_shards;
+  static std::atomic_uint stats_shard_counter;
+  static thread_local uint stats_shard_index;
+
+  auto static local_stats_shard() -> stats_shard&;
+
+  // set once the current transaction has its global tracking callbacks
+  static WSTM::WTransactionLocalFlag transaction_tracked;
 
  protected:
+  // when set, additions are buffered per transaction (see `delta_buffer`) and
+  // applied once, right before the transaction commits; the apply still reads
+  // the chunk it adds to, so concurrent adders to one chunk still conflict, but
+  // only at commit instead of over the whole transaction
+  static bool delta_coalescing;
+
+  // registers the global abort/commit counting, at most once per transaction
+  // no matter how many operations (on how many objects) it runs
   auto static setup_transaction_tracking(WSTM::WAtomic& at) -> void;
 
  public:
+  auto static set_delta_coalescing(bool enabled) -> void;
+
   auto static reset_global_stats() -> void;
   auto static get_global_stats() -> status;
-
-  auto virtual read(WSTM::WAtomic& at) -> uint = 0;
-  // auto virtual inconsistent_read(WSTM::WInconsistent& inc) -> uint = 0;
-  auto virtual add(WSTM::WAtomic& at, uint value) -> void = 0;
-  auto virtual sub(WSTM::WAtomic& at, uint value) -> void = 0;
 };
 
+/// @brief Static interface shared by `single`, `mrv_flex_vector` and
+/// `pr_array`. It replaces the old pure virtual read/add/sub, so that code
+/// templated on the splittable type (benchmarks, Vacation) dispatches
+/// statically.
+template <typename S>
+concept splittable_type =
+    requires(S s, WSTM::WAtomic& at, WSTM::WInconsistent& inc,
+             typename S::value_type value, std::shared_ptr<S> ptr,
+             uint num_threads) {
+      typename S::value_type;
+
+      { S::new_instance(value) } -> std::same_as<std::shared_ptr<S>>;
+      { S::delete_instance(ptr) } -> std::same_as<void>;
+
+      { S::thread_init() } -> std::same_as<void>;
+      { S::global_init(num_threads) } -> std::same_as<void>;
+
+      { S::get_avg_adjust_interval() } -> std::same_as<std::chrono::nanoseconds>;
+      { S::get_avg_balance_interval() } -> std::same_as<std::chrono::nanoseconds>;
+      { S::get_avg_phase_interval() } -> std::same_as<std::chrono::nanoseconds>;
+      { S::reset_global_stats() } -> std::same_as<void>;
+
+      { s.read(at) } -> std::same_as<typename S::value_type>;
+      { s.inconsistent_read(inc) } -> std::same_as<typename S::value_type>;
+      { s.add(at, value) } -> std::same_as<void>;
+      { s.sub(at, value) } -> std::same_as<void>;
+      { s.try_sub(at, value) } -> std::same_as<bool>;
+      { s.track(at) } -> std::same_as<void>;
+    };
+
 }  // namespace splittable
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+
+namespace splittable::utils {
+
+/// @brief Ids of the objects that were used since a manager last took them,
+/// so that its passes only visit those. Each object keeps a flag that is set
+/// while it is in the set; only the first use after the manager cleared it
+/// takes the mutex, so the mutex is taken at most once per object and pass.
+class active_set {
+ private:
+  std::vector<uint> ids;
+  std::mutex mutex;
+
+ public:
+  auto insert(std::atomic_bool& flag, uint id) -> void {
+    // the load keeps the uses of an object that is already queued from
+    // writing to the flag
+    if (flag.load(std::memory_order_relaxed) ||
+        flag.exchange(true, std::memory_order_relaxed)) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->ids.push_back(id);
+  }
+
+  /// @brief Empties the set. The flags of the objects are left set, so the
+  /// caller has to clear each of them before visiting the object; a use after
+  /// that queues it again for the next pass.
+  auto take() -> std::vector<uint> {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return std::exchange(this->ids, {});
+  }
+};
+
+}  // namespace splittable::utils
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <wstm/stm.h>
+
+#include <algorithm>
+#include <concepts>
+
+#include "splittable/splittable.hpp"
+
+namespace splittable::utils {
+
+/// @brief Net value added to one splittable by the current transaction that
+/// has not been applied yet. The first addition registers a single
+/// `BeforeCommit` action that applies the whole delta at once, so repeated
+/// operations on the same object only touch its chunks once.
+/// @tparam V counter type of the splittable
+template <std::integral V>
+class delta_buffer {
+ private:
+  WSTM::WTransactionLocalValue<V> pending;
+
+ public:
+  /// @brief Value buffered so far in this transaction.
+  auto get(WSTM::WAtomic& at) -> V {
+    auto pending = this->pending.Get(at);
+    return pending ? *pending : 0;
+  }
+
+  /// @brief Buffers an addition. `apply(at, delta)` is called once, just
+  /// before the top-level transaction commits, with the net delta.
+  template <typename F>
+  auto add(WSTM::WAtomic& at, V value, F apply) -> void {
+    // the value is always replaced with Set instead of being changed in place,
+    // so that a child transaction that aborts does not leak into its parent
+    if (auto pending = this->pending.Get(at)) {
+      if (would_overflow(*pending, value)) {
+        throw exception(error::overflow);
+      }
+
+      this->pending.Set(*pending + value, at);
+      return;
+    }
+
+    this->pending.Set(value, at);
+    at.BeforeCommit([this, apply](WSTM::WAtomic& at) {
+      auto delta = this->get(at);
+      if (delta != 0) {
+        apply(at, delta);
+      }
+    });
+  }
+
+  /// @brief Subtracts `value`, taking it from the buffered additions first
+  /// and the rest from the splittable itself with `sub(at, rest) -> bool`. If
+  /// `sub` fails the buffer is left untouched.
+  template <typename F>
+  auto sub(WSTM::WAtomic& at, V value, F sub) -> bool {
+    auto pending = this->get(at);
+    auto taken = std::min(pending, value);
+
+    if (taken < value && !sub(at, value - taken)) {
+      return false;
+    }
+
+    if (taken != 0) {
+      this->pending.Set(pending - taken, at);
+    }
+
+    return true;
+  }
+};
+
+}  // namespace splittable::utils
@@ -0,0 +1,35 @@
+#pragma once
+
+namespace splittable::utils {
+
+/// @brief Marks the calling thread as reading epoch-protected data (e.g. an
+/// MRV chunk directory) while alive. Pointers loaded inside a guard stay valid
+/// until it is destroyed, even if they are retired in the meantime. Entering
+/// and leaving only does plain stores to a per-thread slot, no RMW on shared
+/// memory. Guards can be nested.
+class epoch_guard {
+ public:
+  epoch_guard();
+  ~epoch_guard();
+
+  epoch_guard(const epoch_guard&) = delete;
+  epoch_guard& operator=(const epoch_guard&) = delete;
+};
+
+/// @brief Calls `deleter(ptr)` once every thread that could have loaded `ptr`
+/// has left its guard. Must only be called after `ptr` has been unpublished.
+/// Meant for rare updates, since it takes a lock and scans every thread.
+auto epoch_retire(void* ptr, void (*deleter)(void*)) -> void;
+
+template <typename T>
+auto epoch_retire(T* ptr) -> void {
+  epoch_retire(ptr, [](void* ptr) { delete static_cast<T*>(ptr); });
+}
+
+/// @brief Blocks until every guard that was alive when it was called has been
+/// left, so that whatever those guards loaded is no longer in use by them.
+/// Only waits on readers, never takes a lock they take; must not be called
+/// from inside a guard.
+auto epoch_synchronize() -> void;
+
+}  // namespace splittable::utils
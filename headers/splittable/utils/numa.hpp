@@ -0,0 +1,26 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace splittable::utils {
+
+/// @brief Parses a list like "0-3,8-11", in the format used by sysfs and
+/// `taskset -c`; malformed entries are skipped.
+auto parse_cpu_list(const std::string& list) -> std::vector<uint>;
+
+/// @brief Number of NUMA nodes of the machine, read from sysfs once. It is 1
+/// when the topology cannot be read, so callers can always index by node.
+auto numa_node_count() -> uint;
+
+/// @brief Node of the CPU the calling thread is running on. Like
+/// `sched_getcpu`, it can be outdated as soon as it returns.
+auto current_numa_node() -> uint;
+
+/// @brief Runs `fn` with the calling thread pinned to the CPUs of `node`, so
+/// that the memory it allocates and first touches is placed on that node by
+/// the kernel's first-touch policy. The previous affinity is restored after.
+auto run_on_numa_node(uint node, const std::function<void()>& fn) -> void;
+
+}  // namespace splittable::utils
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace splittable::utils {
+
+/// @brief Non-transactional hint of which chunks hold some value. It is only
+/// updated as operations run, so it can be wrong in both directions after an
+/// abort; callers must treat it as a starting point and fall back to a full
+/// scan when it does not add up.
+/// @tparam N maximum number of chunks
+template <size_t N>
+class occupancy_bitmap {
+ private:
+  std::array<std::atomic_uint64_t, (N + 63) / 64> words{};
+
+ public:
+  auto set(size_t index) -> void {
+    auto& word = this->words[index / 64];
+    auto mask = uint64_t{1} << (index % 64);
+
+    // the load keeps adds to chunks that are already marked from writing to
+    // the shared word
+    if ((word.load(std::memory_order_relaxed) & mask) == 0) {
+      word.fetch_or(mask, std::memory_order_relaxed);
+    }
+  }
+
+  auto clear(size_t index) -> void {
+    auto& word = this->words[index / 64];
+    auto mask = uint64_t{1} << (index % 64);
+
+    if ((word.load(std::memory_order_relaxed) & mask) != 0) {
+      word.fetch_and(~mask, std::memory_order_relaxed);
+    }
+  }
+
+  auto set_all(size_t size) -> void {
+    for (auto i = 0u; i < size; ++i) {
+      this->set(i);
+    }
+  }
+
+  /// @brief First marked index in [from, size), or `size` if there is none.
+  auto next(size_t from, size_t size) const -> size_t {
+    while (from < size) {
+      auto word = this->words[from / 64].load(std::memory_order_relaxed);
+      word &= ~uint64_t{0} << (from % 64);
+
+      if (word != 0) {
+        auto index = from / 64 * 64 + std::countr_zero(word);
+        return index < size ? index : size;
+      }
+
+      from = (from / 64 + 1) * 64;
+    }
+
+    return size;
+  }
+};
+
+}  // namespace splittable::utils
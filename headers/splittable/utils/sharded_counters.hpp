@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <thread>
+
+namespace splittable::utils {
+
+/// @brief `N` 64-bit counters of a single object, split over one cache line
+/// per hardware thread, up to `MAX_SHARDS`. Each thread always adds to the
+/// same shard, given out round-robin when it first counts, so threads only
+/// share a line past that many of them; the shards are only added up (and
+/// cleared) when the counters are fetched.
+template <size_t N, size_t MAX_SHARDS = 64>
+class sharded_counters {
+ private:
+  static_assert(std::has_single_bit(MAX_SHARDS));
+
+  struct alignas(std::hardware_destructive_interference_size) shard {
+    std::array<std::atomic_uint64_t, N> counters{};
+  };
+
+  // the same for every instance, and a power of two so a thread finds its
+  // shard with a mask; the shards are allocated per instance, so a machine
+  // with few threads does not pay for `MAX_SHARDS` lines per object
+  auto static shard_count() -> size_t {
+    static const size_t count = std::min<size_t>(
+        std::bit_ceil(std::max(1u, std::thread::hardware_concurrency())),
+        MAX_SHARDS);
+    return count;
+  }
+
+  std::unique_ptr<shard[]> shards = std::make_unique<shard[]>(shard_count());
+
+  auto static local_shard() -> size_t {
+    static std::atomic_size_t next(0);
+    thread_local size_t index =
+        next.fetch_add(1, std::memory_order_relaxed) & (shard_count() - 1);
+    return index;
+  }
+
+ public:
+  // returns the count of the calling thread's shard after the addition
+  auto add(size_t counter, uint64_t count) -> uint64_t {
+    return this->shards[local_shard()].counters[counter].fetch_add(
+               count, std::memory_order_relaxed) +
+           count;
+  }
+
+  /// @brief Totals since the last reset, without clearing them; like
+  /// `fetch_and_reset`, not a snapshot of a single instant.
+  auto load() const -> std::array<uint64_t, N> {
+    std::array<uint64_t, N> totals{};
+
+    for (auto& shard : std::span(this->shards.get(), shard_count())) {
+      for (auto i = 0u; i < N; ++i) {
+        totals[i] += shard.counters[i].load(std::memory_order_relaxed);
+      }
+    }
+
+    return totals;
+  }
+
+  /// @brief Totals since the last call. A shard is read and cleared with one
+  /// exchange per counter, so no count is lost, but the counters of one call
+  /// are not a snapshot of a single instant.
+  auto fetch_and_reset() -> std::array<uint64_t, N> {
+    std::array<uint64_t, N> totals{};
+
+    for (auto& shard : std::span(this->shards.get(), shard_count())) {
+      for (auto i = 0u; i < N; ++i) {
+        // skips the RMW (and the line ownership it needs) on idle shards
+        if (shard.counters[i].load(std::memory_order_relaxed) != 0) {
+          totals[i] +=
+              shard.counters[i].exchange(0, std::memory_order_relaxed);
+        }
+      }
+    }
+
+    return totals;
+  }
+};
+
+}  // namespace splittable::utils
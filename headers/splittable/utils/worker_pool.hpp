@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace splittable::utils {
+
+struct worker_pool_options {
+  // 0 runs the work on the thread that calls `run`; one worker keeps the
+  // passes off the manager's own threads without taking cores from the
+  // clients, and callers that need more ask for them
+  size_t threads = 1;
+  // CPUs the workers are pinned to, one each and in order, wrapping around
+  // when there are more workers than CPUs; empty leaves them unpinned
+  std::vector<uint> cpus;
+  // CPU time all the workers together may spend on one `run`; zero means no
+  // limit
+  std::chrono::nanoseconds cpu_budget{0};
+};
+
+/// @brief Threads of their own for the managers' passes, so that the work is
+/// not scheduled on the application's threads (or on TBB's global arena) and
+/// can be kept off the cores that run client transactions. The items of a
+/// `run` are dealt out to the workers like cards, so each worker goes through
+/// its share from the lowest index up and the lower indexes of all of them run
+/// first; a worker that is done with its share takes items from the others,
+/// one at a time.
+class worker_pool {
+ private:
+  // the items `first`, then every `ranges.size()`-th one after it, up to `end`
+  // of them; `next` of them were claimed already
+  struct alignas(std::hardware_destructive_interference_size) range {
+    std::atomic_size_t next{0};
+    size_t end = 0;
+    size_t first = 0;
+  };
+
+  worker_pool_options options;
+  // one per worker, or a single one when there are no workers
+  std::vector<range> ranges;
+
+  // the current `run`, set before the workers are woken up
+  const std::function<void(size_t)>* task = nullptr;
+  size_t count = 0;
+  std::atomic<std::chrono::nanoseconds::rep> cpu_left{0};
+  uint64_t generation = 0;
+  size_t running = 0;
+
+  std::mutex mutex;
+  std::condition_variable_any start_condition;
+  std::condition_variable_any done_condition;
+
+  std::vector<std::jthread> threads;
+
+  auto worker_main(std::stop_token stop_token, size_t index) -> void;
+  // runs items, starting with the ones of range `index`, until there are none
+  // left or the budget is spent
+  auto work(size_t index) -> void;
+  // next item from range `index`, or from any other if it is empty; `count`
+  // if there are none left
+  auto claim(size_t index, size_t count) -> size_t;
+
+ public:
+  explicit worker_pool(worker_pool_options options);
+  ~worker_pool();
+
+  worker_pool(const worker_pool&) = delete;
+  worker_pool& operator=(const worker_pool&) = delete;
+
+  /// @brief Calls `task` with each index below `count`, on the workers, and
+  /// waits for them. Only one `run` can be going on at a time. Returns the
+  /// indexes that were not run because the CPU budget ran out, which are
+  /// mostly the higher ones, so callers can put the most important items
+  /// first.
+  auto run(size_t count, const std::function<void(size_t)>& task)
+      -> std::vector<size_t>;
+};
+
+}  // namespace splittable::utils
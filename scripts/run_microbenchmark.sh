@@ -1,6 +1,6 @@
 #!/bin/bash
 
-type_list=(single mrv-flex-vector pr-array)
+type_list=(single mrv-flex-vector mrv-array mrv-numa pr-array)
 worker_list=(8)
 read_per_list=(0 5 10 15 20 25 30 35 40 45 50 55 60 65 70 75 80 85 90 95 100)
 padding_list=(100000)
@@ -12,7 +12,7 @@ mrv_balances=(none)
 printf "benchmark,workers,execution time (s),padding,read percentage,writes,reads,write throughput (ops/s),read throughput (ops/s),abort rate,avg adjust interval (ms),avg balance interval (ms),avg phase interval (ms)\n"
 
 for type in ${type_list[@]}; do
-    if [ "$type" == "mrv-flex-vector" ]; then
+    if [ "$type" == "mrv-flex-vector" ] || [ "$type" == "mrv-array" ] || [ "$type" == "mrv-numa" ]; then
         for balance_type in ${mrv_balances[@]}; do
             for workers in ${worker_list[@]}; do
                 for read_per in ${read_per_list[@]}; do
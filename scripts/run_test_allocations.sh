@@ -0,0 +1,16 @@
+#!/bin/bash
+
+type_list=(single mrv-flex-vector pr-array)
+worker_list=(1 4 16 64)
+read_percentage_list=(10 90)
+seconds=10
+
+printf "benchmark,workers,execution time (s),read percentage,operation,operations,allocations,allocations per operation\n"
+
+for type in ${type_list[@]}; do
+    for workers in ${worker_list[@]}; do
+        for read_percentage in ${read_percentage_list[@]}; do
+            ./build/bin/test_allocations -b ${type} -w ${workers} -r ${read_percentage} -d ${seconds}
+        done
+    done
+done
@@ -0,0 +1,24 @@
+#!/bin/bash
+
+type_list=(single mrv-flex-vector pr-array)
+mode_list=(loop batch)
+worker_list=(1 4 16 64)
+batch_list=(2 8 32)
+objects=64
+scale=10
+seconds=10
+runs=3
+
+printf "benchmark,mode,workers,objects,batch size,execution time (s),transactions,throughput (transactions/s),abort rate\n"
+
+for type in ${type_list[@]}; do
+    for mode in ${mode_list[@]}; do
+        for workers in ${worker_list[@]}; do
+            for batch in ${batch_list[@]}; do
+                for _ in $(seq $runs); do
+                    ./build/bin/test_batch -b ${type} -m ${mode} -w ${workers} -o ${objects} -n ${batch} -d ${seconds} -s ${scale}
+                done
+            done
+        done
+    done
+done
@@ -0,0 +1,18 @@
+#!/bin/bash
+
+growth_list=(periodic reactive)
+worker_list=(4 16 64)
+base_workers=1
+scale=10
+seconds=3
+runs=5
+
+printf "growth,base workers,workers,execution time (s),transactions,chunks before,chunks after,reaction time (ms),reactive growths\n"
+
+for growth in ${growth_list[@]}; do
+    for workers in ${worker_list[@]}; do
+        for _ in $(seq $runs); do
+            ./build/bin/test_reaction_time -g ${growth} -b ${base_workers} -w ${workers} -d ${seconds} -s ${scale}
+        done
+    done
+done
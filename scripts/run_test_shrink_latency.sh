@@ -0,0 +1,18 @@
+#!/bin/bash
+
+removal_list=(locked draining)
+worker_list=(1 4 16 64)
+objects=256
+scale=10
+seconds=10
+runs=3
+
+printf "removal,workers,objects,execution time (s),transactions,shrinks,p50 latency (us),p99 latency (us),p99.9 latency (us),max latency (us)\n"
+
+for removal in ${removal_list[@]}; do
+    for workers in ${worker_list[@]}; do
+        for _ in $(seq $runs); do
+            ./build/bin/test_shrink_latency -r ${removal} -w ${workers} -o ${objects} -d ${seconds} -s ${scale}
+        done
+    done
+done
@@ -1,6 +1,6 @@
 #!/bin/bash
 
-splittable_list=(single mrv-flex-vector pr-array)
+splittable_list=(single mrv-flex-vector mrv-array pr-array)
 client_list=(1 2 4 8 16 32 64 128)
 runs=5
 mrv_balances=(none)
@@ -16,7 +16,7 @@ vacation_params=(-n4 -q60 -u90 -r1048 -T4194304)
 echo "benchmark,workers,execution time (s),abort rate,avg adjust interval (ms),avg balance interval (ms),avg phase interval (ms)"
 
 for type in ${splittable_list[@]}; do
-    if [ "$type" == "mrv-flex-vector" ]; then
+    if [ "$type" == "mrv-flex-vector" ] || [ "$type" == "mrv-array" ]; then
         for balance_type in ${mrv_balances[@]}; do
             for client in ${client_list[@]}; do
                 for _ in $(seq $runs); do
@@ -5,9 +5,10 @@
 #include "splittable/benchmarks/vacation/client.h"
 
 // explicit instantiations
-template struct client_t<splittable::single::single>;
-template struct client_t<splittable::mrv::mrv_flex_vector>;
-template struct client_t<splittable::pr::pr_array>;
+template struct client_t<splittable::single::single<vacation_value_t>>;
+template struct client_t<splittable::mrv::mrv_flex_vector<vacation_value_t>>;
+template struct client_t<splittable::mrv::mrv_array<vacation_value_t>>;
+template struct client_t<splittable::pr::pr_array<vacation_value_t>>;
 
 /* =============================================================================
  * client_alloc
@@ -11,9 +11,10 @@
 #include <cassert>
 
 // explicit instantiations
-template struct manager_t<splittable::single::single>;
-template struct manager_t<splittable::mrv::mrv_flex_vector>;
-template struct manager_t<splittable::pr::pr_array>;
+template struct manager_t<splittable::single::single<vacation_value_t>>;
+template struct manager_t<splittable::mrv::mrv_flex_vector<vacation_value_t>>;
+template struct manager_t<splittable::mrv::mrv_array<vacation_value_t>>;
+template struct manager_t<splittable::pr::pr_array<vacation_value_t>>;
 
 /* =============================================================================
  * DECLARATION OF TM_SAFE FUNCTIONS
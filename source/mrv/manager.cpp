@@ -1,84 +1,108 @@
 #include "splittable/mrv/manager.hpp"
 
+#include <algorithm>
+
 namespace splittable::mrv {
 
 manager::manager()
     : total_adjust_time(0),
       adjust_iterations(0),
+      reactive_growths(0),
       total_balance_time(0),
       balance_iterations(0) {
-  // workers.emplace_back(
-  //     // balance worker
-  //     [this](std::stop_token stop_token) {
-  //       while (!stop_token.stop_requested()) {
-  //         std::this_thread::sleep_until(std::chrono::steady_clock::now() +
-  //                                       BALANCE_INTERVAL);
-
-  //         values_type values;
-  //         {
-  //           // the structure is immutable, we only need the lock to fetch it
-  //           std::lock_guard<std::mutex> lock(this->values_mutex);
-  //           values = this->values;
-  //         }
-
-  //         auto start = std::chrono::steady_clock::now();
-
-  //         std::for_each(std::execution::par_unseq, values.begin(),
-  //         values.end(),
-  //                       [](std::pair<uint, std::shared_ptr<mrv>> pair) {
-  //                         pair.second->balance();
-  //                       });
-
-  //         auto end = std::chrono::steady_clock::now();
-
-  //         {
-  //           std::lock_guard<std::mutex> lock(this->balance_time_mutex);
-
-  //           this->total_balance_time += end - start;
-  //           ++this->balance_iterations;
-  //         }
-  //       }
-  //     });
+  workers.emplace_back(
+      // balance worker
+      [this](std::stop_token stop_token) {
+        while (!stop_token.stop_requested()) {
+          std::this_thread::sleep_for(MIN_BALANCE_INTERVAL);
+
+          auto start = std::chrono::steady_clock::now();
+
+          // only the objects whose subs saw uneven chunks are looked at, and
+          // only the ones that are due are balanced
+          auto objects = this->due_balances(this->lookup(this->skewed.take()));
+
+          if (!objects.empty()) {
+            // the pool runs the lower indexes first, so the most skewed
+            // objects are balanced even if the CPU budget runs out
+            auto skipped = this->run_on_pool(
+                objects.size(), [&](size_t i) { objects[i]->balance(); });
+
+            for (auto i : skipped) {
+              objects[i]->balance_schedule.next = start;
+              objects[i]->clear_skewed();
+              objects[i]->mark_skewed();
+            }
+          }
+
+          auto end = std::chrono::steady_clock::now();
+
+          {
+            std::lock_guard<std::mutex> lock(this->balance_time_mutex);
+
+            this->total_balance_time += end - start;
+            ++this->balance_iterations;
+          }
+        }
+      });
 
   workers.emplace_back(
       // adjust worker
       [this](std::stop_token stop_token) {
-        while (!stop_token.stop_requested()) {
-          std::this_thread::sleep_until(std::chrono::steady_clock::now() +
-                                        ADJUST_INTERVAL);
+        auto next_adjust = std::chrono::steady_clock::now() + ADJUST_INTERVAL;
 
-          values_type values;
+        while (!stop_token.stop_requested()) {
+          std::vector<uint> requests;
           {
-            // the structure is immutable, we only need the lock to fetch it
-            std::lock_guard<std::mutex> lock(this->values_mutex);
-            values = this->values;
+            // growth requests wake the worker up before the interval is over;
+            // they are handled here, by the same thread that runs the adjust
+            // phases on the pool, so an object is never resized by both at
+            // once
+            std::unique_lock<std::mutex> lock(this->growth_mutex);
+            this->growth_condition.wait_until(
+                lock, stop_token, next_adjust,
+                [this]() { return !this->growth_requests.empty(); });
+            requests.swap(this->growth_requests);
           }
 
-          auto start = std::chrono::steady_clock::now();
+          if (!requests.empty()) {
+            this->react(requests);
+          }
 
-          std::for_each(std::execution::par_unseq, values.begin(), values.end(),
-                        [](std::pair<uint, std::shared_ptr<mrv>> pair) {
-                          auto counters = pair.second->fetch_and_reset_status();
+          if (std::chrono::steady_clock::now() < next_adjust) {
+            continue;
+          }
 
-                          auto commits = counters.commits;
-                          auto aborts = counters.aborts;
+          auto start = std::chrono::steady_clock::now();
 
-                          if (commits == 0u) {
-                            pair.second->remove_node();
-                            return;
-                          }
+          // only the objects used since the last phase are visited, so the
+          // cost of a phase follows the activity instead of the number of
+          // registered objects
+          auto objects = this->lookup(this->active.take());
 
-                          auto abort_rate =
-                              (double)aborts / (double)(aborts + commits);
+          {
+            auto skipped = this->run_on_pool(objects.size(), [&](size_t i) {
+              objects[i]->clear_active();
+              objects[i]->adjust();
+            });
+
+            // the ones left out by the CPU budget go first in the next phase
+            for (auto i : skipped) {
+              objects[i]->clear_active();
+              objects[i]->mark_active();
+            }
+          }
 
-                          if (abort_rate < MIN_ABORT_RATE) {
-                            pair.second->remove_node();
-                          } else if (abort_rate > MAX_ABORT_RATE) {
-                            pair.second->add_nodes(abort_rate);
-                          }
-                        });
+          // an idle object is shrunk on every phase, so the ones that can
+          // still shrink are kept for the next one, even without any use
+          for (auto& mrv : objects) {
+            if (mrv->shrinkable()) {
+              mrv->mark_active();
+            }
+          }
 
           auto end = std::chrono::steady_clock::now();
+          next_adjust = end + ADJUST_INTERVAL;
 
           {
             std::lock_guard<std::mutex> lock(this->adjust_time_mutex);
@@ -102,6 +126,11 @@ auto manager::register_mrv(std::shared_ptr<mrv> mrv) -> void {
   std::cout << "registering " << mrv->get_id() << "\n";
 #endif
 
+  std::call_once(this->pool_created, [this]() {
+    std::lock_guard<std::mutex> lock(this->pool_mutex);
+    this->pool = std::make_unique<utils::worker_pool>(this->pool_options);
+  });
+
   values_type values;
   {
     std::lock_guard<std::mutex> lock(this->values_mutex);
@@ -125,6 +154,153 @@ auto manager::deregister_mrv(std::shared_ptr<mrv> mrv) -> void {
   }
 }
 
+auto manager::configure_pool(utils::worker_pool_options options) -> void {
+  // waits for the phase that may be running, so the old pool is idle when it
+  // is destroyed
+  std::lock_guard<std::mutex> lock(this->pool_mutex);
+  this->pool_options = std::move(options);
+
+  if (this->pool) {
+    this->pool = std::make_unique<utils::worker_pool>(this->pool_options);
+  }
+}
+
+auto manager::run_on_pool(size_t count,
+                          const std::function<void(size_t)>& task)
+    -> std::vector<size_t> {
+  std::lock_guard<std::mutex> lock(this->pool_mutex);
+
+  // no object was registered yet, so there is nothing to run either
+  if (!this->pool) {
+    return {};
+  }
+
+  return this->pool->run(count, task);
+}
+
+auto manager::activate(std::atomic_bool& flag, uint id) -> void {
+  this->active.insert(flag, id);
+}
+
+auto manager::lookup(const std::vector<uint>& ids)
+    -> std::vector<std::shared_ptr<mrv>> {
+  values_type values;
+  {
+    // the structure is immutable, we only need the lock to fetch it
+    std::lock_guard<std::mutex> lock(this->values_mutex);
+    values = this->values;
+  }
+
+  std::vector<std::shared_ptr<mrv>> objects;
+  objects.reserve(ids.size());
+
+  for (auto id : ids) {
+    // it may have been deregistered since it was queued
+    if (auto mrv = values.find(id)) {
+      objects.push_back(*mrv);
+    }
+  }
+
+  return objects;
+}
+
+auto manager::queue_balance(std::atomic_bool& flag, uint id) -> void {
+  this->skewed.insert(flag, id);
+}
+
+auto manager::due_balances(const std::vector<std::shared_ptr<mrv>>& objects)
+    -> std::vector<std::shared_ptr<mrv>> {
+  using duration = std::chrono::steady_clock::duration;
+
+  auto now = std::chrono::steady_clock::now();
+  std::vector<std::pair<double, std::shared_ptr<mrv>>> due;
+
+  for (auto& mrv : objects) {
+    auto& schedule = mrv->balance_schedule;
+    auto signals = mrv->fetch_and_reset_skew();
+
+    mrv->clear_skewed();
+    schedule.pending += signals.extra_scans + signals.failed_subs;
+
+    if (now < schedule.next) {
+      // it is looked at again once it is due, with the signals it has by then
+      schedule.waited = true;
+      mrv->mark_skewed();
+      continue;
+    }
+
+    auto spread = mrv->chunk_spread();
+    auto pending = schedule.pending;
+    auto waited = schedule.waited;
+
+    schedule.pending = 0;
+    schedule.waited = false;
+
+    if (spread < MIN_BALANCE_SPREAD) {
+      // balancing would not change much, so it backs off
+      schedule.interval =
+          std::min<duration>(schedule.interval * 2, MAX_BALANCE_INTERVAL);
+      schedule.next = now + schedule.interval;
+      continue;
+    }
+
+    // skewed again before its interval was over means the interval is too
+    // long for how fast it gets uneven; skewed only after it means it could
+    // be longer
+    if (waited) {
+      schedule.interval =
+          std::max<duration>(schedule.interval / 2, MIN_BALANCE_INTERVAL);
+    } else {
+      schedule.interval =
+          std::min<duration>(schedule.interval * 2, MAX_BALANCE_INTERVAL);
+    }
+    schedule.next = now + schedule.interval;
+
+    due.emplace_back(spread * pending, mrv);
+  }
+
+  std::sort(due.begin(), due.end(), [](const auto& a, const auto& b) {
+    return a.first > b.first;
+  });
+
+  std::vector<std::shared_ptr<mrv>> sorted;
+  sorted.reserve(due.size());
+  for (auto& [score, mrv] : due) {
+    sorted.push_back(mrv);
+  }
+
+  return sorted;
+}
+
+auto manager::request_growth(uint id) -> void {
+  {
+    std::lock_guard<std::mutex> lock(this->growth_mutex);
+    this->growth_requests.push_back(id);
+  }
+
+  this->growth_condition.notify_one();
+}
+
+auto manager::react(const std::vector<uint>& ids) -> void {
+  auto objects = this->lookup(ids);
+
+  // on the pool like the phases, so the growths are also pinned and count
+  // towards the CPU budget
+  auto skipped = this->run_on_pool(
+      objects.size(), [&](size_t i) { objects[i]->react(); });
+
+  // requeueing them would have the worker spin on requests it has no budget
+  // for; they are still active, so the next adjust phase sizes them anyway
+  for (auto i : skipped) {
+    objects[i]->drop_growth_request();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->adjust_time_mutex);
+    this->reactive_growths += objects.size() - skipped.size();
+  }
+}
+
 auto manager::get_avg_adjust_interval() -> std::chrono::nanoseconds {
   {
     std::lock_guard<std::mutex> lock(this->adjust_time_mutex);
@@ -149,12 +325,18 @@ auto manager::get_avg_balance_interval() -> std::chrono::nanoseconds {
   }
 }
 
+auto manager::get_reactive_growths() -> uint64_t {
+  std::lock_guard<std::mutex> lock(this->adjust_time_mutex);
+  return this->reactive_growths;
+}
+
 auto manager::reset_global_stats() -> void {
   {
     std::scoped_lock lock(this->adjust_time_mutex, this->balance_time_mutex);
 
     this->total_adjust_time = std::chrono::nanoseconds{0};
     this->adjust_iterations = 0;
+    this->reactive_growths = 0;
 
     this->total_balance_time = std::chrono::nanoseconds{0};
     this->balance_iterations = 0;
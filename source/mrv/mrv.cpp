@@ -1,10 +1,166 @@
 #include "splittable/mrv/mrv.hpp"
 
+#include <algorithm>
+#include <cmath>
+
+#include "splittable/mrv/manager.hpp"
+
 namespace splittable::mrv {
 
 std::atomic_uint mrv::id_counter{0};
+bool mrv::reactive_growth(true);
 
 auto mrv::thread_init() -> void {}
 auto mrv::global_init(uint) -> void {}
 
+auto mrv::set_reactive_growth(bool enabled) -> void {
+  reactive_growth = enabled;
+}
+
+auto mrv::track_abort_streak(uint count) -> void {
+  if (!reactive_growth) {
+    return;
+  }
+
+  auto window = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    ABORT_STREAK_WINDOW)
+                    .count();
+  auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+  auto start = this->streak_start.load(std::memory_order_relaxed);
+
+  // the first abort after the window is over starts a new one, dropping the
+  // attempts counted since the last one; if threads race here, the counts of
+  // the losers may be dropped too, which only delays the signal a bit
+  if (now - start > window &&
+      this->streak_start.compare_exchange_strong(start, now,
+                                                 std::memory_order_relaxed)) {
+    this->streak_counters.fetch_and_reset();
+  }
+
+  auto local = this->streak_counters.add(ABORTS_COUNTER, count);
+
+  // the rate is only looked at when this thread's aborts cross a multiple of
+  // the interval, and not at all while a growth is already queued, so the
+  // aborts of a contended object rarely read the other threads' shards
+  if ((local - count) / ABORT_STREAK_CHECK_INTERVAL ==
+          local / ABORT_STREAK_CHECK_INTERVAL ||
+      this->growth_requested.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  auto counters = this->streak_counters.load();
+  auto attempts = counters[ATTEMPTS_COUNTER];
+
+  if (attempts >= ABORT_STREAK_MIN_ATTEMPTS &&
+      static_cast<double>(counters[ABORTS_COUNTER]) / attempts >
+          MAX_ABORT_RATE &&
+      !this->growth_requested.exchange(true, std::memory_order_relaxed)) {
+    manager::get_instance().request_growth(this->get_id());
+  }
+}
+
+auto mrv::adjust_decision(status counters, double& abort_rate) -> adjust_t {
+  auto commits = counters.commits;
+  auto aborts = counters.aborts;
+
+  if (commits == 0u) {
+    abort_rate = 0.0;
+    return adjust_t::shrink;
+  }
+
+  abort_rate = (double)aborts / (double)(aborts + commits);
+
+  if (abort_rate < MIN_ABORT_RATE) {
+    return adjust_t::shrink;
+  } else if (abort_rate > MAX_ABORT_RATE) {
+    return adjust_t::grow;
+  }
+
+  return adjust_t::keep;
+}
+
+auto mrv::nodes_to_remove(size_t size, double abort_rate) -> size_t {
+  if (size < 2) {
+    return 0;
+  }
+
+  auto share = std::clamp(1.0 - abort_rate / MIN_ABORT_RATE, 0.0, 1.0);
+  auto to_remove = (size_t)std::lround(size / 2.0 * share);
+
+  return std::clamp<size_t>(to_remove, 1, size - 1);
+}
+
+auto mrv::adjust() -> void {
+  auto abort_rate = 0.0;
+
+  switch (adjust_decision(this->fetch_and_reset_status(), abort_rate)) {
+    case adjust_t::grow:
+      this->add_nodes(abort_rate);
+      break;
+    case adjust_t::shrink:
+      this->remove_nodes(abort_rate);
+      break;
+    case adjust_t::keep:
+      break;
+  }
+}
+
+auto mrv::shrinkable() -> bool { return this->chunk_count() > 1; }
+
+auto mrv::mark_active() -> void {
+  manager::get_instance().activate(this->active, this->get_id());
+}
+
+auto mrv::clear_active() -> void {
+  this->active.store(false, std::memory_order_relaxed);
+}
+
+auto mrv::record_skew(size_t scanned, bool covered) -> void {
+  if (scanned <= 1 && covered) {
+    return;
+  }
+
+  if (scanned > 1) {
+    this->skew_counters.add(EXTRA_SCANS_COUNTER, scanned - 1);
+  }
+  if (!covered) {
+    this->skew_counters.add(FAILED_SUBS_COUNTER, 1);
+  }
+
+  this->mark_skewed();
+}
+
+auto mrv::mark_skewed() -> void {
+  manager::get_instance().queue_balance(this->skewed, this->get_id());
+}
+
+auto mrv::clear_skewed() -> void {
+  this->skewed.store(false, std::memory_order_relaxed);
+}
+
+auto mrv::drop_growth_request() -> void {
+  this->growth_requested.store(false, std::memory_order_relaxed);
+}
+
+auto mrv::fetch_and_reset_skew() -> skew {
+  auto counters = this->skew_counters.fetch_and_reset();
+
+  return {.extra_scans = counters[EXTRA_SCANS_COUNTER],
+          .failed_subs = counters[FAILED_SUBS_COUNTER]};
+}
+
+auto mrv::track_streak_attempts(uint count) -> void {
+  if (reactive_growth) {
+    this->streak_counters.add(ATTEMPTS_COUNTER, count);
+  }
+}
+
+auto mrv::react() -> void {
+  // a new streak has to build up before the object is queued again
+  this->streak_counters.fetch_and_reset();
+  this->growth_requested.store(false, std::memory_order_relaxed);
+
+  this->add_nodes(MAX_ABORT_RATE);
+}
+
 }  // namespace splittable::mrv
\ No newline at end of file
@@ -0,0 +1,369 @@
+#include "splittable/mrv/mrv_array.hpp"
+
+namespace splittable::mrv {
+
+// explicit instantiations
+template class mrv_array<uint32_t>;
+template class mrv_array<uint64_t>;
+template class mrv_array<int64_t>;
+
+template <std::integral V>
+std::function<void(WSTM::WAtomic&, chunk_array_t<V>&)>
+    mrv_array<V>::balance_strategy;
+
+template <std::integral V>
+mrv_array<V>::mrv_array(V value) {
+  this->id = mrv::id_counter.fetch_add(1, std::memory_order_relaxed);
+
+  auto chunks = std::make_shared<chunk_array_t<V>>();
+  chunks->emplace_back(value);
+  this->chunks = WSTM::WVar<std::shared_ptr<chunk_array_t<V>>>(chunks);
+}
+
+template <std::integral V>
+auto mrv_array<V>::new_instance(V value) -> std::shared_ptr<mrv_array> {
+  auto obj = std::make_shared<mrv_array>(value);
+  manager::get_instance().register_mrv(obj);
+  return obj;
+}
+
+template <std::integral V>
+auto mrv_array<V>::delete_instance(std::shared_ptr<mrv_array> obj) -> void {
+  manager::get_instance().deregister_mrv(obj);
+}
+
+template <std::integral V>
+auto mrv_array<V>::set_balance_strategy(balance_strategy_t strategy) -> void {
+  balance_strategy = balance_function<V, chunk_array_t<V>>(strategy);
+}
+
+template <std::integral V>
+auto mrv_array<V>::get_id() -> uint {
+  return this->id;
+}
+
+template <std::integral V>
+auto mrv_array<V>::chunk_count() -> size_t {
+  return this->chunks.GetReadOnly()->size();
+}
+
+template <std::integral V>
+auto mrv_array<V>::chunk_spread() -> double {
+  return WSTM::Inconsistently([&](WSTM::WInconsistent& inc) {
+    auto chunks = this->chunks.GetInconsistent(inc);
+    return inconsistent_spread<V>(inc, *chunks, chunks->size());
+  });
+}
+
+template <std::integral V>
+auto mrv_array<V>::get_avg_adjust_interval() -> std::chrono::nanoseconds {
+  return manager::get_instance().get_avg_adjust_interval();
+}
+
+template <std::integral V>
+auto mrv_array<V>::get_avg_balance_interval() -> std::chrono::nanoseconds {
+  return manager::get_instance().get_avg_balance_interval();
+}
+
+template <std::integral V>
+auto mrv_array<V>::get_avg_phase_interval() -> std::chrono::nanoseconds {
+  return std::chrono::nanoseconds(0);
+}
+
+template <std::integral V>
+auto mrv_array<V>::reset_global_stats() -> void {
+  splittable::reset_global_stats();
+  manager::get_instance().reset_global_stats();
+}
+
+template <std::integral V>
+auto mrv_array<V>::add_aborts(uint count) -> void {
+  this->status_counters.add(ABORTS_COUNTER, count);
+  this->track_abort_streak(count);
+}
+
+template <std::integral V>
+auto mrv_array<V>::add_attempts(uint count) -> void {
+  this->status_counters.add(ATTEMPTS_COUNTER, count);
+  this->track_streak_attempts(count);
+  this->mark_active();
+}
+
+template <std::integral V>
+auto mrv_array<V>::fetch_and_reset_status() -> status {
+  auto counters = this->status_counters.fetch_and_reset();
+
+  auto attempts = counters[ATTEMPTS_COUNTER];
+  auto aborts = counters[ABORTS_COUNTER];
+
+  // see `mrv_flex_vector::fetch_and_reset_status`
+  auto commits = attempts > aborts ? attempts - aborts : 0;
+
+  return {.aborts = aborts, .commits = commits};
+}
+
+template <std::integral V>
+auto mrv_array<V>::setup_status_tracking(WSTM::WAtomic& at) -> void {
+  if (this->status_tracked.TestAndSet(at)) {
+    return;
+  }
+
+  this->add_attempts(1u);
+  at.OnFail([this]() { this->add_aborts(1u); });
+}
+
+template <std::integral V>
+auto mrv_array<V>::read(WSTM::WAtomic& at) -> V {
+  setup_transaction_tracking(at);
+
+  V sum = snapshot_sum(snapshot<V>(at, *this->chunks.Get(at)));
+
+  if (delta_coalescing) {
+    sum += this->deltas.get(at);
+  }
+
+  return sum;
+}
+
+template <std::integral V>
+auto mrv_array<V>::inconsistent_read(WSTM::WInconsistent& inc) -> V {
+  V sum = 0;
+  auto chunks = this->chunks.GetInconsistent(inc);
+  {
+    WSTM::WReadLockGuard<WSTM::WInconsistent> lock(inc);
+
+    for (auto& chunk : *chunks) {
+      sum += chunk.GetInconsistent(inc);
+    }
+  }
+
+  return sum;
+}
+
+template <std::integral V>
+auto mrv_array<V>::add(WSTM::WAtomic& at, V value) -> void {
+  setup_transaction_tracking(at);
+  this->setup_status_tracking(at);
+
+  if (delta_coalescing) {
+    this->deltas.add(at, value, [this](WSTM::WAtomic& at, V delta) {
+      this->add_to_chunks(at, delta);
+    });
+    return;
+  }
+
+  this->add_to_chunks(at, value);
+}
+
+template <std::integral V>
+auto mrv_array<V>::add_to_chunks(WSTM::WAtomic& at, V value) -> void {
+  auto& chunks = *this->chunks.Get(at);
+  auto& chunk = chunks[utils::random_index(0, chunks.size() - 1)];
+
+  auto current_value = chunk.Get(at);
+
+  if (would_overflow(current_value, value)) {
+    throw exception(error::overflow);
+  }
+
+  chunk.Set(current_value + value, at);
+}
+
+template <std::integral V>
+auto mrv_array<V>::sub(WSTM::WAtomic& at, V value) -> void {
+  setup_transaction_tracking(at);
+
+  // see `mrv_flex_vector::sub`
+  if (!this->apply_sub(at, value)) {
+    throw exception(error::insufficient_value);
+  }
+
+  this->setup_status_tracking(at);
+}
+
+template <std::integral V>
+auto mrv_array<V>::try_sub(WSTM::WAtomic& at, V value) -> bool {
+  setup_transaction_tracking(at);
+
+  // no stock is not a failure here, the transaction still commits
+  this->setup_status_tracking(at);
+
+  return this->apply_sub(at, value);
+}
+
+template <std::integral V>
+auto mrv_array<V>::track(WSTM::WAtomic& at) -> void {
+  setup_transaction_tracking(at);
+  this->setup_status_tracking(at);
+}
+
+template <std::integral V>
+auto mrv_array<V>::apply_sub(WSTM::WAtomic& at, V value) -> bool {
+  if (delta_coalescing) {
+    return this->deltas.sub(at, value, [this](WSTM::WAtomic& at, V value) {
+      return this->sub_from_chunks(at, value);
+    });
+  }
+
+  return this->sub_from_chunks(at, value);
+}
+
+template <std::integral V>
+auto mrv_array<V>::sub_from_chunks(WSTM::WAtomic& at, V value) -> bool {
+  auto& chunks = *this->chunks.Get(at);
+  auto size = chunks.size();
+  auto start = utils::random_index(0, size - 1);
+
+  // same two passes as `mrv_flex_vector::sub_from_chunks`: find how many
+  // chunks cover the value, then drain them
+  V available = 0;
+  auto needed = 0u;
+  while (needed < size && available < value) {
+    available += chunks[(start + needed) % size].Get(at);
+    ++needed;
+  }
+
+  this->record_skew(needed, available >= value);
+
+  if (available < value) {
+    return false;
+  }
+
+  for (auto i = 0u; i < needed; ++i) {
+    auto& chunk = chunks[(start + i) % size];
+    auto current_chunk = chunk.Get(at);
+
+    if (current_chunk >= value) {
+      chunk.Set(current_chunk - value, at);
+      break;
+    } else if (current_chunk != 0) {
+      value -= current_chunk;
+      chunk.Set(0, at);
+    }
+  }
+
+  return true;
+}
+
+template <std::integral V>
+auto mrv_array<V>::resize(uint size) -> void {
+  WSTM::Atomically(
+      [&](WSTM::WAtomic& at) {
+        auto& current = *this->chunks.Get(at);
+        auto current_size = current.size();
+
+        std::vector<V> values(size, 0);
+        {
+          WSTM::WReadLockGuard<WSTM::WAtomic> lock(at);
+
+          for (auto i = 0u; i < current_size; ++i) {
+            auto value = current[i].Get(at);
+
+            if (i < size) {
+              values[i] = value;
+              continue;
+            }
+
+            auto& absorber = values[utils::random_index(0, size - 1)];
+            if (would_overflow(absorber, value)) {
+              throw exception(error::overflow);
+            }
+            absorber += value;
+          }
+        }
+
+        // the new chunks are not visible to anyone until the array is
+        // published, so they can just be created with their values
+        auto resized = std::make_shared<chunk_array_t<V>>();
+        resized->reserve(size);
+        for (auto value : values) {
+          resized->emplace_back(value);
+        }
+
+        // every transaction that got the old array conflicts with this, so
+        // a regular transaction is enough: no write to a dropped chunk can
+        // commit after it, unlike with the directory of `mrv_flex_vector`
+        this->chunks.Set(resized, at);
+      },
+      // bounded instead of run locked, so a busy object does not stop every
+      // other transaction, and an idle one being shrunk does not either;
+      // `WMaxConflictsException` leaves it for the next adjust phase
+      WSTM::WMaxConflicts(RESIZE_MAX_CONFLICTS,
+                          WSTM::WConflictResolution::THROW));
+}
+
+template <std::integral V>
+auto mrv_array<V>::add_nodes(double abort_rate) -> void {
+  auto size = this->chunks.GetReadOnly()->size();
+
+  if (size >= MAX_NODES) {
+    return;
+  }
+
+  auto to_add =
+      std::min((size_t)std::lround(1 + size * abort_rate), MAX_NODES - size);
+
+  if (to_add < 1) {
+    return;
+  }
+
+  try {
+    this->resize(size + to_add);
+  } catch (WSTM::WMaxConflictsException&) {
+    // it will be tried again in the next adjust phase
+    return;
+  } catch (exception& ex) {
+    // it will be tried again in the next adjust phase
+    return;
+  }
+
+#ifdef SPLITTABLE_DEBUG
+  std::cout << "increased id=" << this->id << " w/abort " << abort_rate
+            << " | new size: " << size + to_add << "\n";
+#endif
+}
+
+template <std::integral V>
+auto mrv_array<V>::remove_nodes(double abort_rate) -> void {
+  auto size = this->chunks.GetReadOnly()->size();
+  auto to_remove = nodes_to_remove(size, abort_rate);
+
+  if (to_remove == 0) {
+    return;
+  }
+
+  try {
+    // the dropped chunks are all merged in this one resize
+    this->resize(size - to_remove);
+  } catch (WSTM::WMaxConflictsException&) {
+    // it will be tried again in the next adjust phase
+    return;
+  } catch (exception& ex) {
+    // it will be tried again in the next adjust phase
+    return;
+  }
+
+#ifdef SPLITTABLE_DEBUG
+  std::cout << "decreased id=" << this->id << " w/abort " << abort_rate
+            << " | new size: " << size - to_remove << "\n";
+#endif
+}
+
+template <std::integral V>
+auto mrv_array<V>::balance() -> void {
+  // see `mrv_flex_vector::balance`
+  if (!balance_strategy) {
+    return;
+  }
+
+  try {
+    WSTM::Atomically([&](WSTM::WAtomic& at) {
+      balance_strategy(at, *this->chunks.Get(at));
+    });
+  } catch (exception& ex) {
+    // there is no problem if an exception is thrown, this will be tried again
+    // in the next balance phase
+  }
+}
+
+}  // namespace splittable::mrv
@@ -1,453 +1,910 @@
 #include "splittable/mrv/mrv_flex_vector.hpp"
 
-namespace splittable::mrv {
+#include <sched.h>
+
+#include <thread>
 
-std::function<void(WSTM::WAtomic&, chunks_t)> mrv_flex_vector::balance_strategy;
+namespace splittable::mrv {
 
-mrv_flex_vector::mrv_flex_vector(uint value) : status_counters(0) {
+// explicit instantiations
+template class mrv_flex_vector<uint32_t>;
+template class mrv_flex_vector<uint64_t>;
+template class mrv_flex_vector<int64_t>;
+
+template <std::integral V>
+std::function<void(WSTM::WAtomic&, chunks_t<V>&)>
+    mrv_flex_vector<V>::balance_strategy;
+template <std::integral V>
+add_strategy_t mrv_flex_vector<V>::add_strategy(add_strategy_t::direct);
+template <std::integral V>
+chunk_selection_t mrv_flex_vector<V>::chunk_selection(
+    chunk_selection_t::random);
+template <std::integral V>
+bool mrv_flex_vector<V>::read_aggregation(false);
+template <std::integral V>
+removal_strategy_t mrv_flex_vector<V>::removal_strategy(
+    removal_strategy_t::draining);
+template <std::integral V>
+thread_local bool mrv_flex_vector<V>::chunk_conflict(false);
+
+template <std::integral V>
+mrv_flex_vector<V>::mrv_flex_vector(V value) {
   this->id = mrv::id_counter.fetch_add(1, std::memory_order_relaxed);
 
   // const auto size = 2;
   // auto new_value = value / size;
   // auto remainder = value % size;
 
-  // immer::flex_vector_transient<std::shared_ptr<chunk_t>> transient_chunks;
-  // transient_chunks.push_back(std::make_shared<chunk_t>(new_value + remainder));
+  // immer::flex_vector_transient<std::shared_ptr<chunk_t<V>>> transient_chunks;
+  // transient_chunks.push_back(std::make_shared<chunk_t<V>>(new_value + remainder));
   // for (size_t i = 1; i < size; ++i) {
-  //   transient_chunks.push_back(std::make_shared<chunk_t>(new_value));
+  //   transient_chunks.push_back(std::make_shared<chunk_t<V>>(new_value));
   // }
   // auto chunks = transient_chunks.persistent();
 
-  auto chunks = chunks_t{std::make_shared<chunk_t>(value)};
-  this->chunks = std::make_shared<chunks_t>(chunks);
+  auto chunks = chunks_t<V>{std::make_shared<chunk_t<V>>(value)};
+  this->directory = new directory_t<V>{.chunks = chunks, .active = 1};
+
+  if (value != 0) {
+    this->occupied.set(0);
+  }
+
+  if (read_aggregation) {
+    this->group_sums.reserve(MAX_NODES / GROUP_SIZE);
+    this->group_sums.emplace_back(value);
+    for (auto i = 1u; i < MAX_NODES / GROUP_SIZE; ++i) {
+      this->group_sums.emplace_back(0);
+    }
+  }
+
+  if (add_strategy == add_strategy_t::commutative) {
+    auto slots = std::max(1u, std::thread::hardware_concurrency());
+    this->add_slots.reserve(slots);
+    for (auto i = 0u; i < slots; ++i) {
+      this->add_slots.emplace_back(0);
+    }
+  }
 }
 
-auto mrv_flex_vector::new_instance(uint value)
+template <std::integral V>
+mrv_flex_vector<V>::~mrv_flex_vector() {
+  // no one else can be using the object (and so its directory) anymore
+  delete this->directory.load();
+}
+
+template <std::integral V>
+auto mrv_flex_vector<V>::new_instance(V value)
     -> std::shared_ptr<mrv_flex_vector> {
   auto obj = std::make_shared<mrv_flex_vector>(value);
   manager::get_instance().register_mrv(obj);
   return obj;
 }
 
-auto mrv_flex_vector::delete_instance(std::shared_ptr<mrv_flex_vector> obj)
+template <std::integral V>
+auto mrv_flex_vector<V>::delete_instance(std::shared_ptr<mrv_flex_vector> obj)
     -> void {
   manager::get_instance().deregister_mrv(obj);
 }
 
-auto mrv_flex_vector::get_id() -> uint { return this->id; }
+template <std::integral V>
+auto mrv_flex_vector<V>::set_chunk_selection(chunk_selection_t selection)
+    -> void {
+  chunk_selection = selection;
+}
+
+template <std::integral V>
+auto mrv_flex_vector<V>::set_removal_strategy(removal_strategy_t strategy)
+    -> void {
+  removal_strategy = strategy;
+}
+
+template <std::integral V>
+auto mrv_flex_vector<V>::set_add_strategy(add_strategy_t strategy) -> void {
+  add_strategy = strategy;
+}
+
+template <std::integral V>
+auto mrv_flex_vector<V>::set_read_aggregation(bool enabled) -> void {
+  read_aggregation = enabled;
+}
 
-auto mrv_flex_vector::get_avg_adjust_interval() -> std::chrono::nanoseconds {
+template <std::integral V>
+auto mrv_flex_vector<V>::pick_chunk(size_t size) -> size_t {
+  if (chunk_selection == chunk_selection_t::cpu && !chunk_conflict) {
+    // the CPU can change right after this call, which is fine: it only
+    // affects where the operation starts, not its correctness
+    auto cpu = sched_getcpu();
+    if (cpu >= 0) {
+      return static_cast<size_t>(cpu) % size;
+    }
+  }
+
+  chunk_conflict = false;
+  return utils::random_index(0, size - 1);
+}
+
+template <std::integral V>
+auto mrv_flex_vector<V>::buffers_deltas() -> bool {
+  return delta_coalescing || !this->add_slots.empty();
+}
+
+template <std::integral V>
+auto mrv_flex_vector<V>::local_slot() -> size_t {
+  // round-robin over the threads that use any object, so the threads of a
+  // benchmark get a slot each as long as there are as many slots as threads;
+  // past that they share them, which is still correct
+  static std::atomic_size_t next(0);
+  thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed);
+  return index;
+}
+
+template <std::integral V>
+auto mrv_flex_vector<V>::get_id() -> uint {
+  return this->id;
+}
+
+template <std::integral V>
+auto mrv_flex_vector<V>::chunk_count() -> size_t {
+  utils::epoch_guard guard;
+  return this->directory.load(std::memory_order_acquire)->chunks.size();
+}
+
+template <std::integral V>
+auto mrv_flex_vector<V>::chunk_spread() -> double {
+  return WSTM::Inconsistently([&](WSTM::WInconsistent& inc) {
+    utils::epoch_guard guard;
+    auto& directory = *this->directory.load(std::memory_order_acquire);
+    return inconsistent_spread<V>(inc, directory.chunks, directory.active);
+  });
+}
+
+template <std::integral V>
+auto mrv_flex_vector<V>::get_avg_adjust_interval() -> std::chrono::nanoseconds {
   return manager::get_instance().get_avg_adjust_interval();
 }
 
-auto mrv_flex_vector::get_avg_balance_interval() -> std::chrono::nanoseconds {
+template <std::integral V>
+auto mrv_flex_vector<V>::get_avg_balance_interval()
+    -> std::chrono::nanoseconds {
   return manager::get_instance().get_avg_balance_interval();
 }
 
-auto mrv_flex_vector::get_avg_phase_interval() -> std::chrono::nanoseconds {
+template <std::integral V>
+auto mrv_flex_vector<V>::get_avg_phase_interval() -> std::chrono::nanoseconds {
   return std::chrono::nanoseconds(0);
 }
 
-auto mrv_flex_vector::reset_global_stats() -> void {
+template <std::integral V>
+auto mrv_flex_vector<V>::reset_global_stats() -> void {
   splittable::reset_global_stats();
   manager::get_instance().reset_global_stats();
 }
 
-auto mrv_flex_vector::add_aborts(uint count) -> void {
-  this->status_counters.fetch_add(count << 16, std::memory_order_relaxed);
+template <std::integral V>
+auto mrv_flex_vector<V>::add_aborts(uint count) -> void {
+  this->status_counters.add(ABORTS_COUNTER, count);
+  this->track_abort_streak(count);
 }
 
-auto mrv_flex_vector::add_commits(uint count) -> void {
-  this->status_counters.fetch_add(count, std::memory_order_relaxed);
+template <std::integral V>
+auto mrv_flex_vector<V>::add_attempts(uint count) -> void {
+  this->status_counters.add(ATTEMPTS_COUNTER, count);
+  this->track_streak_attempts(count);
+  this->mark_active();
 }
 
-auto mrv_flex_vector::fetch_and_reset_status() -> status {
-  auto counters =
-      this->status_counters.fetch_and(0u, std::memory_order_relaxed);
+template <std::integral V>
+auto mrv_flex_vector<V>::fetch_and_reset_status() -> status {
+  auto counters = this->status_counters.fetch_and_reset();
 
-  auto commits = (counters & 0x0000FFFF);
-  auto aborts = (counters & 0xFFFF0000) >> 16;
+  auto attempts = counters[ATTEMPTS_COUNTER];
+  auto aborts = counters[ABORTS_COUNTER];
+
+  // an abort can land after the reset that took its attempt, so this may go
+  // below zero
+  auto commits = attempts > aborts ? attempts - aborts : 0;
 
   return {.aborts = aborts, .commits = commits};
 }
 
-auto mrv_flex_vector::read(WSTM::WAtomic& at) -> uint {
+template <std::integral V>
+auto mrv_flex_vector<V>::setup_status_tracking(WSTM::WAtomic& at) -> void {
+  if (this->status_tracked.TestAndSet(at)) {
+    return;
+  }
+
+  // only `this` is captured so the closure fits in the small buffer of
+  // `std::function`; there is no `After` callback, since one could run after
+  // the object has been freed by the very transaction that removed it
+  this->add_attempts(1u);
+  at.OnFail([this]() {
+    this->add_aborts(1u);
+    chunk_conflict = true;
+  });
+}
+
+template <std::integral V>
+auto mrv_flex_vector<V>::read(WSTM::WAtomic& at) -> V {
   setup_transaction_tracking(at);
 
   // a read does not count for the purposes of the abort rate, so no lambdas are
   // needed here
 
-  uint sum = 0;
-  auto chunks = *std::atomic_load(&this->chunks).get();
-  {
+  V sum = 0;
+  utils::epoch_guard guard;
+  auto& chunks = this->directory.load(std::memory_order_acquire)->chunks;
+
+  if (!this->group_sums.empty()) {
     // this will improve performance since we are reading a lot of variables in
     // one go
     WSTM::WReadLockGuard<WSTM::WAtomic> lock(at);
 
-    for (auto&& value : chunks) {
-      sum += value->Get(at);
+    // groups past the last chunk are always zero, so they can be skipped
+    auto groups = (chunks.size() + GROUP_SIZE - 1) / GROUP_SIZE;
+    for (auto i = 0u; i < groups; ++i) {
+      sum += this->group_sums[i].Get(at);
+    }
+  } else {
+    // the snapshot holds a single read lock for all the chunks
+    sum = snapshot_sum(snapshot<V>(at, chunks));
+  }
+
+  if (!this->add_slots.empty()) {
+    WSTM::WReadLockGuard<WSTM::WAtomic> lock(at);
+
+    for (auto& slot : this->add_slots) {
+      sum += slot.Get(at);
     }
   }
 
+  if (this->buffers_deltas()) {
+    sum += this->deltas.get(at);
+  }
+
   return sum;
 }
 
-auto mrv_flex_vector::add(WSTM::WAtomic& at, uint value) -> void {
-  setup_transaction_tracking(at);
+template <std::integral V>
+auto mrv_flex_vector<V>::inconsistent_read(WSTM::WInconsistent& inc) -> V {
+  V sum = 0;
+  utils::epoch_guard guard;
+  auto& chunks = this->directory.load(std::memory_order_acquire)->chunks;
+  {
+    // one read lock for all the chunks, like in `read`
+    WSTM::WReadLockGuard<WSTM::WInconsistent> lock(inc);
 
-  at.OnFail([this]() { this->add_aborts(1u); });
-  at.After([ptr = weak_from_this()]() {
-    // this weak_ptr was needed to avoid a segfault in Vacation
-    if (auto value = ptr.lock()) {
-      value->add_commits(1u);
+    for (auto&& value : chunks) {
+      sum += value->GetInconsistent(inc);
     }
-  });
 
-  auto chunks = *std::atomic_load(&this->chunks).get();
-  auto index = utils::random_index(0, chunks.size() - 1);
+    // value added through the slots is not in the chunks until it is folded
+    for (auto& slot : this->add_slots) {
+      sum += slot.GetInconsistent(inc);
+    }
+  }
 
-  auto current_value = chunks[index]->Get(at);
-  assert(current_value <= (current_value + value));  // wraparound check
-  current_value += value;
-  chunks[index]->Set(current_value, at);
+  return sum;
 }
 
-auto mrv_flex_vector::sub(WSTM::WAtomic& at, uint value) -> void {
+template <std::integral V>
+auto mrv_flex_vector<V>::add(WSTM::WAtomic& at, V value) -> void {
   setup_transaction_tracking(at);
+  this->setup_status_tracking(at);
+
+  if (this->buffers_deltas()) {
+    // the chunk (or slot) is only picked and read when the delta is applied,
+    // right before the commit, so concurrent adders cannot invalidate this
+    // transaction while it runs
+    this->deltas.add(at, value, [this](WSTM::WAtomic& at, V delta) {
+      this->commit_add(at, delta);
+    });
+    return;
+  }
 
-  auto no_stock = std::make_shared<bool>(false);
+  this->add_to_chunks(at, value);
+}
 
-  at.OnFail([this, no_stock]() {
-    // if this function is called and `no_stock` is true, we know that the
-    // transaction failed due to no stock, so we do not need to increment the
-    // abort counter
-    if (*no_stock.get()) {
-      return;
-    }
-    this->add_aborts(1u);
-  });
-  at.After([this]() { this->add_commits(1u); });
+template <std::integral V>
+auto mrv_flex_vector<V>::commit_add(WSTM::WAtomic& at, V value) -> void {
+  if (this->add_slots.empty()) {
+    this->add_to_chunks(at, value);
+    return;
+  }
 
-  auto chunks = *std::atomic_load(&this->chunks).get();
-  auto size = chunks.size();
-  auto start = utils::random_index(0, size - 1);
-  auto index = start;
-  auto success = false;
+  // while there is a slot per thread, no other thread adds to this one. WSTM
+  // has no write-only update, though, so this is still a read and a write of
+  // the slot, and the transactions that touch it at once (threads sharing it,
+  // or a sub or fold draining it) still conflict at commit
+  auto& slot = this->add_slots[local_slot() % this->add_slots.size()];
+  auto current_value = slot.Get(at);
 
-  while (true) {
-    auto current_chunk = chunks[index]->Get(at);
+  if (would_overflow(current_value, value)) {
+    throw exception(error::overflow);
+  }
 
-    if (current_chunk > value) {
-      chunks[index]->Set(current_chunk - value, at);
-      success = true;
-      break;
-    } else if (current_chunk != 0) {
-      value -= current_chunk;
-      chunks[index]->Set(0, at);
-    }
+  slot.Set(current_value + value, at);
+}
 
-    index = (index + 1) % size;
-    if (index == start) {
-      break;
-    }
+template <std::integral V>
+auto mrv_flex_vector<V>::add_to_chunks(WSTM::WAtomic& at, V value) -> void {
+  utils::epoch_guard guard;
+  auto& directory = *this->directory.load(std::memory_order_acquire);
+  auto& chunks = directory.chunks;
+  auto index = pick_chunk(directory.active);
+
+  auto current_value = chunks[index]->Get(at);
+
+  if (would_overflow(current_value, value)) {
+    throw exception(error::overflow);
   }
 
-  if (!success) {
-    *no_stock = true;
-    throw exception();
+  current_value += value;
+  chunks[index]->Set(current_value, at);
+  this->add_to_group(at, index, value);
+
+  if (current_value != 0) {
+    this->occupied.set(index);
   }
 }
 
-auto mrv_flex_vector::add_nodes(double abort_rate) -> void {
-  auto chunks = *std::atomic_load(&this->chunks).get();
-  auto size = chunks.size();
+template <std::integral V>
+auto mrv_flex_vector<V>::sub(WSTM::WAtomic& at, V value) -> void {
+  setup_transaction_tracking(at);
 
-  // TODO: this is not exactly like the original impl, revise later
-  if (size >= MAX_NODES) {
-    return;
+  // a transaction that fails due to no stock is not counted as an abort, so
+  // the tracking is only set up once the subtraction went through; `Get` does
+  // not throw on conflicts, so no abort can be missed this way
+  if (!this->apply_sub(at, value)) {
+    throw exception(error::insufficient_value);
   }
 
-  auto to_add =
-      std::min((size_t)std::lround(1 + size * abort_rate), MAX_NODES - size);
+  this->setup_status_tracking(at);
+}
 
-  if (to_add < 1) {
-    return;
-  }
+template <std::integral V>
+auto mrv_flex_vector<V>::try_sub(WSTM::WAtomic& at, V value) -> bool {
+  setup_transaction_tracking(at);
 
-  auto t = chunks.transient();
-  for (auto i = 0u; i < to_add; ++i) {
-    t.push_back(std::make_shared<chunk_t>(0u));
-  }
+  // no stock is not a failure here, the transaction still commits
+  this->setup_status_tracking(at);
 
-  std::atomic_store(&this->chunks, std::make_shared<chunks_t>(t.persistent()));
+  return this->apply_sub(at, value);
+}
 
-#ifdef SPLITTABLE_DEBUG
-  auto new_size = size + to_add;
-  std::cout << "increased id=" << id << " w/abort " << abort_rate
-            << " | new size: " << new_size << "\n";
-#endif
+template <std::integral V>
+auto mrv_flex_vector<V>::track(WSTM::WAtomic& at) -> void {
+  setup_transaction_tracking(at);
+  this->setup_status_tracking(at);
+}
+
+template <std::integral V>
+auto mrv_flex_vector<V>::apply_sub(WSTM::WAtomic& at, V value) -> bool {
+  if (this->buffers_deltas()) {
+    return this->deltas.sub(at, value, [this](WSTM::WAtomic& at, V value) {
+      return this->sub_from_chunks(at, value);
+    });
+  }
+
+  return this->sub_from_chunks(at, value);
 }
 
-auto mrv_flex_vector::remove_node() -> void {
-  auto chunks = *std::atomic_load(&this->chunks).get();
+template <std::integral V>
+auto mrv_flex_vector<V>::sub_from_chunks(WSTM::WAtomic& at, V value) -> bool {
+  utils::epoch_guard guard;
+  auto& directory = *this->directory.load(std::memory_order_acquire);
+  auto& chunks = directory.chunks;
+  // chunks being removed are scanned too, since they may still hold value
   auto size = chunks.size();
+  // with `chunk_selection_t::cpu` this is the home chunk, and the scan below
+  // only moves on to the next ones if it does not have enough value
+  auto start = pick_chunk(directory.active);
+
+  // indexes of the chunks that cover the value, in the order they are drained
+  std::array<uint16_t, MAX_NODES> picked;
+  auto needed = 0u;
+  V available = 0;
+  // every chunk read, empty or not, for the skew signals
+  auto scanned = 0u;
+
+  auto take = [&](size_t index) {
+    auto chunk_value = chunks[index]->Get(at);
+    ++scanned;
+
+    if (chunk_value == 0) {
+      this->occupied.clear(index);
+      return;
+    }
 
-  // TODO: check if removing does not go below min nodes
-  if (size < 2) {
-    return;
+    picked[needed++] = index;
+    available += chunk_value;
+  };
+
+  // first, only read the chunks until we know how many of them are needed to
+  // cover the value; this way a failed subtraction does not leave the chunks
+  // half-drained, which matters now that the transaction may still commit.
+  // Past the start chunk, only the ones the summary marks as holding value are
+  // read, in ring order, so a low-stock object does not read every chunk
+  take(start);
+  for (auto i = this->occupied.next(start + 1, size);
+       available < value && i < size; i = this->occupied.next(i + 1, size)) {
+    take(i);
+  }
+  for (auto i = this->occupied.next(0, start); available < value && i < start;
+       i = this->occupied.next(i + 1, start)) {
+    take(i);
   }
 
-  auto last_chunk = chunks[size - 1];
-  auto absorber = chunks[utils::random_index(0, size - 2)];
-  auto new_chunks = std::make_shared<chunks_t>(chunks.take(size - 1));
+  // the summary is only a hint (an aborted drain can leave a chunk unmarked),
+  // so every chunk is read before giving up
+  if (available < value) {
+    needed = 0;
+    available = 0;
+
+    for (auto i = 0u; i < size && available < value; ++i) {
+      auto index = (start + i) % size;
+      auto chunk_value = chunks[index]->Get(at);
+      ++scanned;
+
+      if (chunk_value != 0) {
+        this->occupied.set(index);
+        picked[needed++] = index;
+        available += chunk_value;
+      }
+    }
+  }
 
-  WSTM::Atomically(
-      [&](WSTM::WAtomic& at) {
-        auto last_chunk_value = last_chunk->Get(at);
+  // what the chunks cannot cover is taken from the add slots, before anything
+  // is drained; the picked chunks are then drained completely
+  if (available < value) {
+    if (!this->sub_from_slots(at, value - available)) {
+      this->record_skew(scanned, false);
+      return false;
+    }
 
-        // this ensures that other threads reading/writing to the last_chunk
-        // will conflict
-        last_chunk->Set(0, at);
+    value = available;
+  }
 
-        if (last_chunk_value > 0) {
-          absorber->Set(absorber->Get(at) + last_chunk_value, at);
-        }
+  this->record_skew(scanned, true);
 
-        std::atomic_store(&this->chunks, new_chunks);
-      },
-      // this should make the transaction irrevocable; if it doesn't,
-      // there's no problem anyway
-      WSTM::WMaxConflicts(0, WSTM::WConflictResolution::RUN_LOCKED));
+  // then drain them; these reads hit the values already cached in the
+  // transaction
+  for (auto i = 0u; i < needed; ++i) {
+    auto& chunk = chunks[picked[i]];
+    auto current_chunk = chunk->Get(at);
 
-#ifdef SPLITTABLE_DEBUG
-  std::cout << "decreased id=" << this->id << " by one\n";
-#endif
-}
+    if (current_chunk > value) {
+      chunk->Set(current_chunk - value, at);
+      this->sub_from_group(at, picked[i], value);
+      break;
+    }
 
-auto mrv_flex_vector::balance() -> void {
-  try {
-    WSTM::Atomically([&](WSTM::WAtomic& at) {
-      auto chunks = *std::atomic_load(&this->chunks).get();
-      balance_strategy(at, chunks);
-    });
-  } catch (exception& ex) {
-    // there is no problem if an exception is thrown, this will be tried again
-    // in the next balance phase
+    value -= current_chunk;
+    chunk->Set(0, at);
+    this->sub_from_group(at, picked[i], current_chunk);
+    this->occupied.clear(picked[i]);
   }
+
+  return true;
 }
 
-auto balance_all(WSTM::WAtomic& at, chunks_t chunks) -> void {
-  auto size = chunks.size();
+template <std::integral V>
+auto mrv_flex_vector<V>::sub_from_slots(WSTM::WAtomic& at, V value) -> bool {
+  auto size = this->add_slots.size();
 
-  if (size < 2) {
-    throw exception();
+  if (size == 0) {
+    return false;
   }
 
-  uint64_t total = 0;
+  // the caller's slot first, since it is the one it adds to
+  auto start = local_slot() % size;
+
+  // same two passes as for the chunks
+  V available = 0;
+  auto needed = 0u;
   {
     WSTM::WReadLockGuard<WSTM::WAtomic> lock(at);
-    for (auto i = 0u; i < size; ++i) {
-      total += chunks[i]->Get(at);
+
+    while (needed < size && available < value) {
+      available += this->add_slots[(start + needed) % size].Get(at);
+      ++needed;
     }
   }
 
-  // TODO: check for unneeded balances; not sure if it is feasible here, we
-  // would have to make many comparisons just to check if we need to abort,
-  // seems like it would incur in a big overhead
-
-  auto new_value = total / size;
-  auto remainder = total % size;
-
-  chunks[0]->Set(new_value + remainder, at);
-  for (auto i = 1u; i < size; ++i) {
-    chunks[i]->Set(new_value, at);
+  if (available < value) {
+    return false;
   }
-}
 
-auto balance_minmax(WSTM::WAtomic& at, chunks_t chunks) -> void {
-  auto size = chunks.size();
+  for (auto i = 0u; i < needed; ++i) {
+    auto& slot = this->add_slots[(start + i) % size];
+    auto current_slot = slot.Get(at);
 
-  if (size < 2) {
-    throw exception();
+    if (current_slot >= value) {
+      slot.Set(current_slot - value, at);
+      break;
+    } else if (current_slot != 0) {
+      value -= current_slot;
+      slot.Set(0, at);
+    }
   }
 
-  auto min_i = 0u;
-  auto min_v = UINT_MAX;
-  auto max_i = 0u;
-  auto max_v = 0u;
-
-  uint read_value;
-  for (auto i = 0u; i < size; ++i) {
-    read_value = chunks[i]->Get(at);
+  return true;
+}
 
-    if (read_value > max_v) {
-      max_v = read_value;
-      max_i = i;
+template <std::integral V>
+auto mrv_flex_vector<V>::fold_slots() -> void {
+  for (auto& slot : this->add_slots) {
+    // an inconsistent read is enough to skip the empty ones, without running a
+    // transaction for each
+    auto value = WSTM::Inconsistently(
+        [&](WSTM::WInconsistent& inc) { return slot.GetInconsistent(inc); });
+    if (value == 0) {
+      continue;
     }
 
-    if (read_value <= min_v) {
-      min_v = read_value;
-      min_i = i;
+    try {
+      WSTM::Atomically(
+          [&](WSTM::WAtomic& at) {
+            auto value = slot.Get(at);
+            if (value == 0) {
+              return;
+            }
+
+            slot.Set(0, at);
+            this->add_to_chunks(at, value);
+          },
+          WSTM::WMaxConflicts(FOLD_MAX_CONFLICTS,
+                              WSTM::WConflictResolution::THROW));
+    } catch (WSTM::WMaxConflictsException&) {
+      // its thread keeps adding to it; the subs can still take the value
+    } catch (exception& ex) {
+      // the chunk it was added to would overflow; it is tried again in the
+      // next adjust phase
     }
   }
+}
 
-  if (min_i == max_i || max_v - min_v <= MIN_BALANCE_DIFF) {
-    throw exception();
+template <std::integral V>
+auto mrv_flex_vector<V>::add_to_group(WSTM::WAtomic& at, size_t index,
+                                      V value) -> void {
+  if (this->group_sums.empty()) {
+    return;
   }
 
-  auto new_value = (max_v + min_v) / 2;
-  auto remainder = (max_v + min_v) % 2;
+  // the chunks already hold this value, so the group sum cannot overflow
+  auto& group = this->group_sums[index / GROUP_SIZE];
+  group.Set(group.Get(at) + value, at);
+}
 
-  chunks[min_i]->Set(new_value + remainder, at);
-  chunks[max_i]->Set(new_value, at);
+template <std::integral V>
+auto mrv_flex_vector<V>::sub_from_group(WSTM::WAtomic& at, size_t index,
+                                        V value) -> void {
+  if (this->group_sums.empty()) {
+    return;
+  }
+
+  auto& group = this->group_sums[index / GROUP_SIZE];
+  group.Set(group.Get(at) - value, at);
 }
 
-auto compare_less(const std::pair<uint, uint>& a,
-                  const std::pair<uint, uint>& b) -> bool {
-  return a.second < b.second;
-};
+template <std::integral V>
+auto mrv_flex_vector<V>::refresh_groups(WSTM::WAtomic& at,
+                                        chunks_t<V>& chunks) -> void {
+  if (this->group_sums.empty()) {
+    return;
+  }
+
+  auto values = snapshot<V>(at, chunks);
 
-auto compare_greater(const std::pair<uint, uint>& a,
-                     const std::pair<uint, uint>& b) -> bool {
-  return a.second > b.second;
-};
+  for (auto i = 0u; i * GROUP_SIZE < values.size(); ++i) {
+    V sum = snapshot_sum(values.subspan(
+        i * GROUP_SIZE, std::min(GROUP_SIZE, values.size() - i * GROUP_SIZE)));
 
-auto constexpr calculate_k(size_t num_records) -> size_t {
-  if (num_records < 4) {
-    return 1;
+    // only write the ones that changed, so readers of the others are not
+    // invalidated
+    if (this->group_sums[i].Get(at) != sum) {
+      this->group_sums[i].Set(sum, at);
+    }
   }
+}
 
-  if (num_records <= 16) {
-    return 2;
+template <std::integral V>
+auto mrv_flex_vector<V>::add_nodes(double abort_rate) -> void {
+  // the manager is the only writer of the directory, so it does not need to
+  // be protected here
+  auto old_directory = this->directory.load();
+  auto& chunks = old_directory->chunks;
+  auto size = chunks.size();
+
+  // TODO: this is not exactly like the original impl, revise later
+  if (size >= MAX_NODES) {
+    return;
+  }
+
+  auto to_add =
+      std::min((size_t)std::lround(1 + size * abort_rate), MAX_NODES - size);
+
+  if (to_add < 1) {
+    return;
   }
 
-  if (num_records < 64) {
-    return num_records / 8;
+  auto t = chunks.transient();
+  for (auto i = 0u; i < to_add; ++i) {
+    t.push_back(std::make_shared<chunk_t<V>>(0));
   }
 
-  return num_records / 16;
+  auto new_size = size + to_add;
+  auto grown = t.persistent();
+  this->directory.store(
+      new directory_t<V>{.chunks = grown, .active = new_size});
+  utils::epoch_retire(old_directory);
+
+  // the new chunks are already in use at this point, so this is a regular
+  // transaction, like any other writer, and not a locked one; chunks left
+  // empty by an earlier grow are filled along with these
+  auto from = this->unspread_from != 0 ? std::min(this->unspread_from, size)
+                                       : size;
+  this->try_spread(from);
+
+#ifdef SPLITTABLE_DEBUG
+  std::cout << "increased id=" << id << " w/abort " << abort_rate
+            << " | new size: " << new_size << "\n";
+#endif
 }
 
-auto balance_minmax_with_k(WSTM::WAtomic& at, chunks_t chunks) -> void {
+template <std::integral V>
+auto mrv_flex_vector<V>::try_spread(size_t from) -> void {
+  // copied, since the manager may retire the directory later on; it is the
+  // only one replacing it, so this is also the current one
+  auto chunks = this->directory.load()->chunks;
   auto size = chunks.size();
 
-  if (size < 2) {
-    throw exception();
+  if (from >= size) {
+    // the chunks waiting for value were removed in the meantime
+    this->unspread_from = 0;
+    return;
   }
 
-  const uint k = calculate_k(size);
+  try {
+    WSTM::Atomically(
+        [&](WSTM::WAtomic& at) { this->spread_value(at, chunks, from); },
+        WSTM::WMaxConflicts(SPREAD_MAX_CONFLICTS,
+                            WSTM::WConflictResolution::THROW));
+    this->unspread_from = 0;
+    this->occupied.set_all(size);
+  } catch (WSTM::WMaxConflictsException&) {
+    // every sub that commits on the object invalidates the read of all its
+    // chunks, so right after a grow this can keep failing; the new chunks
+    // still work while empty
+    this->unspread_from = from;
+  }
+}
 
-  std::priority_queue<std::pair<uint, uint>, std::vector<std::pair<uint, uint>>,
-                      std::function<bool(const std::pair<uint, uint>& a,
-                                         const std::pair<uint, uint>& b)>>
-      smallest_numbers(compare_less);
-  std::priority_queue<std::pair<uint, uint>, std::vector<std::pair<uint, uint>>,
-                      std::function<bool(const std::pair<uint, uint>& a,
-                                         const std::pair<uint, uint>& b)>>
-      largest_numbers(compare_greater);
+template <std::integral V>
+auto mrv_flex_vector<V>::merge_chunks(WSTM::WAtomic& at, chunks_t<V>& chunks,
+                                      size_t new_size,
+                                      const std::vector<size_t>& absorbers)
+    -> void {
+  for (auto i = 0u; i < absorbers.size(); ++i) {
+    auto& removed = chunks[new_size + i];
+    auto removed_value = removed->Get(at);
 
-  uint read_value;
-  for (auto i = 0u; i < size; ++i) {
-    read_value = chunks[i]->Get(at);
+    // this ensures that other threads reading/writing to the removed chunks
+    // will conflict
+    removed->Set(0, at);
 
-    if (smallest_numbers.size() < k) {
-      smallest_numbers.push(std::make_pair(i, read_value));
-    } else if (read_value < smallest_numbers.top().second) {
-      smallest_numbers.pop();
-      smallest_numbers.push(std::make_pair(i, read_value));
+    if (removed_value == 0) {
+      continue;
     }
 
-    if (largest_numbers.size() < k) {
-      largest_numbers.push(std::make_pair(i, read_value));
-    } else if (read_value > largest_numbers.top().second) {
-      largest_numbers.pop();
-      largest_numbers.push(std::make_pair(i, read_value));
+    auto& absorber = chunks[absorbers[i]];
+    auto absorber_value = absorber->Get(at);
+
+    if (would_overflow(absorber_value, removed_value)) {
+      throw exception(error::overflow);
     }
+
+    absorber->Set(absorber_value + removed_value, at);
+    this->sub_from_group(at, new_size + i, removed_value);
+    this->add_to_group(at, absorbers[i], removed_value);
   }
+}
 
-  std::vector<uint> indexes;
-  indexes.reserve(k + k);
+template <std::integral V>
+auto mrv_flex_vector<V>::spread_value(WSTM::WAtomic& at, chunks_t<V>& chunks,
+                                      size_t from) -> void {
+  auto size = chunks.size();
+  auto values = snapshot<V>(at, chunks);
+  V share = snapshot_sum(values) / static_cast<sum_t<V>>(size);
 
-  uint64_t total = 0;
-  while (!smallest_numbers.empty()) {
-    auto small = smallest_numbers.top();
-    smallest_numbers.pop();
-    indexes.push_back(small.first);
-    total += small.second;
-  }
-  while (!largest_numbers.empty()) {
-    auto large = largest_numbers.top();
-    largest_numbers.pop();
-    indexes.push_back(large.first);
-    total += large.second;
+  if (share <= 0) {
+    return;
   }
 
-  // TODO: check for unneeded balances
-  // if (min_i == max_i || max_v - min_v <= MIN_BALANCE_DIFF) {
-  //   throw exception();
-  // }
-
-  auto new_value = total / (k + k);
-  auto remainder = total % (k + k);
+  // each new chunk is filled up to an even share, taking only what the old
+  // chunks have above it, so no chunk ends up below the share because of this
+  std::vector<V> targets(values.begin(), values.end());
+  auto donor = 0u;
+  for (auto i = from; i < size && donor < from; ++i) {
+    while (targets[i] < share && donor < from) {
+      if (targets[donor] <= share) {
+        ++donor;
+        continue;
+      }
+
+      V moved = std::min<V>(targets[donor] - share, share - targets[i]);
+      targets[donor] -= moved;
+      targets[i] += moved;
+    }
+  }
 
-  for (auto& i : indexes) {
-    if (i == indexes[0]) {
-      chunks[i]->Set(new_value + remainder, at);
-    } else {
-      chunks[i]->Set(new_value, at);
+  for (auto i = 0u; i < size; ++i) {
+    if (targets[i] > values[i]) {
+      chunks[i]->Set(targets[i], at);
+      this->add_to_group(at, i, targets[i] - values[i]);
+    } else if (targets[i] < values[i]) {
+      chunks[i]->Set(targets[i], at);
+      this->sub_from_group(at, i, values[i] - targets[i]);
     }
   }
 }
 
-auto balance_none(WSTM::WAtomic&, chunks_t) -> void {}
-
-auto balance_random(WSTM::WAtomic& at, chunks_t chunks) -> void {
+template <std::integral V>
+auto mrv_flex_vector<V>::remove_nodes(double abort_rate) -> void {
+  auto old_directory = this->directory.load();
+  // copied, since the old directory is retired before this is done with it
+  auto chunks = old_directory->chunks;
   auto size = chunks.size();
+  auto to_remove = nodes_to_remove(size, abort_rate);
+
+  if (to_remove == 0) {
+    return;
+  }
+
+  // the last `to_remove` chunks are merged into random ones of those that are
+  // kept
+  auto new_size = size - to_remove;
+  auto new_directory =
+      new directory_t<V>{.chunks = chunks.take(new_size), .active = new_size};
+
+  std::vector<size_t> absorbers(to_remove);
+  for (auto& absorber : absorbers) {
+    absorber = utils::random_index(0, new_size - 1);
+  }
 
-  if (size < 2) {
-    throw exception();
+  if (removal_strategy == removal_strategy_t::locked) {
+    try {
+      WSTM::Atomically(
+          [&](WSTM::WAtomic& at) {
+            this->merge_chunks(at, chunks, new_size, absorbers);
+            this->directory.store(new_directory);
+          },
+          // this should make the transaction irrevocable; if it doesn't,
+          // there's no problem anyway
+          WSTM::WMaxConflicts(0, WSTM::WConflictResolution::RUN_LOCKED));
+    } catch (exception& ex) {
+      // an earlier attempt may have published the new directory already, and
+      // someone may be reading it, so it is put back and retired instead of
+      // deleted; it will be tried again in the next adjust phase
+      auto expected = new_directory;
+      this->directory.compare_exchange_strong(expected, old_directory);
+      utils::epoch_retire(new_directory);
+      return;
+    }
+
+    utils::epoch_retire(old_directory);
+  } else {
+    // first, new operations stop adding to the removed chunks...
+    auto draining = new directory_t<V>{.chunks = chunks, .active = new_size};
+    this->directory.store(draining);
+    utils::epoch_retire(old_directory);
+
+    // ...then the operations that loaded the old directory are waited on, so
+    // the old directory can be reclaimed. This does not stop writes to the
+    // removed chunks: a transaction that picked one can still be running, and
+    // commit, after its operation returned. What keeps those writes from being
+    // lost is the merge below, which reads each removed chunk and sets it to
+    // zero, so a transaction that also wrote it either commits first, and its
+    // value is merged, or conflicts and retries on the current directory
+    utils::epoch_synchronize();
+
+    // nothing was moved, so the chunks can just be used again; it will be
+    // tried again in the next adjust phase
+    auto undo = [&]() {
+      delete new_directory;
+      this->directory.store(
+          new directory_t<V>{.chunks = chunks, .active = size});
+      utils::epoch_retire(draining);
+    };
+
+    try {
+      // bounded, since every commit on one of the chunks it reads makes it
+      // retry, and the manager should not be stuck on one busy object
+      WSTM::Atomically(
+          [&](WSTM::WAtomic& at) {
+            this->merge_chunks(at, chunks, new_size, absorbers);
+          },
+          WSTM::WMaxConflicts(MERGE_MAX_CONFLICTS,
+                              WSTM::WConflictResolution::THROW));
+    } catch (WSTM::WMaxConflictsException&) {
+      undo();
+      return;
+    } catch (exception& ex) {
+      undo();
+      return;
+    }
+
+    // the removed chunks are empty and are not picked by new operations, so
+    // they can be unlinked; a transaction that still writes one conflicts
+    // with the merge's zeroing, as above, and retries
+    this->directory.store(new_directory);
+    utils::epoch_retire(draining);
   }
 
-  auto i = utils::random_index(0, size - 1);
-  auto j = utils::random_index(0, size - 1);
+  // a false positive on an absorber only costs one extra read later
+  for (auto i = 0u; i < to_remove; ++i) {
+    this->occupied.set(absorbers[i]);
+    this->occupied.clear(new_size + i);
+  }
 
-  if (i == j) {
-    j = (i + 1) % size;
+#ifdef SPLITTABLE_DEBUG
+  std::cout << "decreased id=" << this->id << " w/abort " << abort_rate
+            << " | new size: " << new_size << "\n";
+#endif
+}
+
+template <std::integral V>
+auto mrv_flex_vector<V>::adjust() -> void {
+  mrv::adjust();
+
+  // a grow of this phase already tried it again
+  if (this->unspread_from != 0) {
+    this->try_spread(this->unspread_from);
   }
 
-  auto i_val = chunks[i]->Get(at);
-  auto j_val = chunks[j]->Get(at);
+  // the object is only adjusted after it was used, which is also the only way
+  // for its add slots to fill up
+  this->fold_slots();
+}
 
-  if (i_val == j_val || (i_val > j_val && i_val - j_val <= MIN_BALANCE_DIFF) ||
-      (i_val < j_val && j_val - i_val <= MIN_BALANCE_DIFF)) {
-    throw exception();
+template <std::integral V>
+auto mrv_flex_vector<V>::balance() -> void {
+  // no strategy was set, so there is nothing to run
+  if (!balance_strategy) {
+    return;
   }
 
-  auto new_value = (i_val + j_val) / 2;
-  auto remainder = (i_val + j_val) % 2;
+  try {
+    size_t size = 0;
 
-  chunks[i]->Set(new_value + remainder, at);
-  chunks[j]->Set(new_value, at);
+    WSTM::Atomically([&](WSTM::WAtomic& at) {
+      utils::epoch_guard guard;
+      auto& directory = *this->directory.load(std::memory_order_acquire);
+      size = directory.active;
+
+      // chunks being removed are left out, so no value is moved into them
+      if (directory.active == directory.chunks.size()) {
+        balance_strategy(at, directory.chunks);
+      } else {
+        auto active = directory.chunks.take(directory.active);
+        balance_strategy(at, active);
+      }
+
+      // the strategies move value between chunks without knowing about groups
+      this->refresh_groups(at, directory.chunks);
+    });
+
+    // the strategies may have moved value into any chunk
+    this->occupied.set_all(size);
+  } catch (exception& ex) {
+    // there is no problem if an exception is thrown, this will be tried again
+    // in the next balance phase
+  }
 }
 
-auto mrv_flex_vector::set_balance_strategy(balance_strategy_t strategy)
+template <std::integral V>
+auto mrv_flex_vector<V>::set_balance_strategy(balance_strategy_t strategy)
     -> void {
-  switch (strategy) {
-    case balance_strategy_t::none:
-      balance_strategy = balance_none;
-      break;
-    case balance_strategy_t::random:
-      balance_strategy = balance_random;
-      break;
-    case balance_strategy_t::minmax:
-      balance_strategy = balance_minmax;
-      break;
-    case balance_strategy_t::all:
-      balance_strategy = balance_all;
-      break;
-    default:
-      assert(false);
-  }
+  balance_strategy = balance_function<V, chunks_t<V>>(strategy);
 }
 
 }  // namespace splittable::mrv
@@ -0,0 +1,529 @@
+#include "splittable/mrv/mrv_numa.hpp"
+
+namespace splittable::mrv {
+
+// explicit instantiations
+template class mrv_numa<uint32_t>;
+template class mrv_numa<uint64_t>;
+template class mrv_numa<int64_t>;
+
+template <std::integral V>
+std::function<void(WSTM::WAtomic&, chunk_array_t<V>&)>
+    mrv_numa<V>::balance_strategy;
+
+template <std::integral V>
+mrv_numa<V>::mrv_numa(V value) : balance_rounds(0) {
+  this->id = mrv::id_counter.fetch_add(1, std::memory_order_relaxed);
+
+  // the value starts on the node of the creator, which is the one most likely
+  // to use it first
+  auto home = utils::current_numa_node();
+
+  for (auto node = 0u; node < utils::numa_node_count(); ++node) {
+    utils::run_on_numa_node(node, [&]() {
+      auto chunks = std::make_shared<chunk_array_t<V>>();
+      chunks->emplace_back(node == home ? value : 0);
+
+      auto group = std::make_unique<node_group>();
+      group->chunks = WSTM::WVar<std::shared_ptr<chunk_array_t<V>>>(chunks);
+      this->nodes.push_back(std::move(group));
+    });
+  }
+}
+
+template <std::integral V>
+auto mrv_numa<V>::new_instance(V value) -> std::shared_ptr<mrv_numa> {
+  auto obj = std::make_shared<mrv_numa>(value);
+  manager::get_instance().register_mrv(obj);
+  return obj;
+}
+
+template <std::integral V>
+auto mrv_numa<V>::delete_instance(std::shared_ptr<mrv_numa> obj) -> void {
+  manager::get_instance().deregister_mrv(obj);
+}
+
+template <std::integral V>
+auto mrv_numa<V>::set_balance_strategy(balance_strategy_t strategy) -> void {
+  balance_strategy = balance_function<V, chunk_array_t<V>>(strategy);
+}
+
+template <std::integral V>
+auto mrv_numa<V>::max_group_size() -> size_t {
+  return std::max<size_t>(1, MAX_NODES / utils::numa_node_count());
+}
+
+template <std::integral V>
+auto mrv_numa<V>::get_id() -> uint {
+  return this->id;
+}
+
+template <std::integral V>
+auto mrv_numa<V>::chunk_count() -> size_t {
+  size_t count = 0;
+
+  for (auto& group : this->nodes) {
+    count += group->chunks.GetReadOnly()->size();
+  }
+
+  return count;
+}
+
+template <std::integral V>
+auto mrv_numa<V>::shrinkable() -> bool {
+  return this->chunk_count() > this->nodes.size();
+}
+
+template <std::integral V>
+auto mrv_numa<V>::chunk_spread() -> double {
+  return WSTM::Inconsistently([&](WSTM::WInconsistent& inc) {
+    auto spread = 0.0;
+
+    for (auto& group : this->nodes) {
+      auto chunks = group->chunks.GetInconsistent(inc);
+      spread = std::max(
+          spread, inconsistent_spread<V>(inc, *chunks, chunks->size()));
+    }
+
+    return spread;
+  });
+}
+
+template <std::integral V>
+auto mrv_numa<V>::get_avg_adjust_interval() -> std::chrono::nanoseconds {
+  return manager::get_instance().get_avg_adjust_interval();
+}
+
+template <std::integral V>
+auto mrv_numa<V>::get_avg_balance_interval() -> std::chrono::nanoseconds {
+  return manager::get_instance().get_avg_balance_interval();
+}
+
+template <std::integral V>
+auto mrv_numa<V>::get_avg_phase_interval() -> std::chrono::nanoseconds {
+  return std::chrono::nanoseconds(0);
+}
+
+template <std::integral V>
+auto mrv_numa<V>::reset_global_stats() -> void {
+  splittable::reset_global_stats();
+  manager::get_instance().reset_global_stats();
+}
+
+template <std::integral V>
+auto mrv_numa<V>::add_aborts(uint count) -> void {
+  auto& group = *this->nodes[utils::current_numa_node()];
+  group.status_counters.add(ABORTS_COUNTER, count);
+  this->track_abort_streak(count);
+}
+
+template <std::integral V>
+auto mrv_numa<V>::add_attempts(uint count) -> void {
+  auto& group = *this->nodes[utils::current_numa_node()];
+  group.status_counters.add(ATTEMPTS_COUNTER, count);
+  this->track_streak_attempts(count);
+  this->mark_active();
+}
+
+template <std::integral V>
+auto mrv_numa<V>::fetch_and_reset_status(uint node) -> status {
+  auto counters = this->nodes[node]->status_counters.fetch_and_reset();
+
+  auto attempts = counters[ATTEMPTS_COUNTER];
+  auto aborts = counters[ABORTS_COUNTER];
+
+  // see `mrv_flex_vector::fetch_and_reset_status`
+  auto commits = attempts > aborts ? attempts - aborts : 0;
+
+  return {.aborts = aborts, .commits = commits};
+}
+
+template <std::integral V>
+auto mrv_numa<V>::fetch_and_reset_status() -> status {
+  status total = {.aborts = 0, .commits = 0};
+
+  for (auto node = 0u; node < this->nodes.size(); ++node) {
+    auto counters = this->fetch_and_reset_status(node);
+    total.aborts += counters.aborts;
+    total.commits += counters.commits;
+  }
+
+  return total;
+}
+
+template <std::integral V>
+auto mrv_numa<V>::setup_status_tracking(WSTM::WAtomic& at) -> void {
+  if (this->status_tracked.TestAndSet(at)) {
+    return;
+  }
+
+  // the abort goes to the node the attempt was counted on, even if the thread
+  // has moved since
+  auto& counters = this->nodes[utils::current_numa_node()]->status_counters;
+  counters.add(ATTEMPTS_COUNTER, 1u);
+  at.OnFail([&counters]() { counters.add(ABORTS_COUNTER, 1u); });
+}
+
+template <std::integral V>
+auto mrv_numa<V>::read(WSTM::WAtomic& at) -> V {
+  setup_transaction_tracking(at);
+
+  V sum = 0;
+  for (auto& group : this->nodes) {
+    sum += snapshot_sum(snapshot<V>(at, *group->chunks.Get(at)));
+  }
+
+  if (delta_coalescing) {
+    sum += this->deltas.get(at);
+  }
+
+  return sum;
+}
+
+template <std::integral V>
+auto mrv_numa<V>::inconsistent_read(WSTM::WInconsistent& inc) -> V {
+  V sum = 0;
+  WSTM::WReadLockGuard<WSTM::WInconsistent> lock(inc);
+
+  for (auto& group : this->nodes) {
+    auto chunks = group->chunks.GetInconsistent(inc);
+    for (auto& chunk : *chunks) {
+      sum += chunk.GetInconsistent(inc);
+    }
+  }
+
+  return sum;
+}
+
+template <std::integral V>
+auto mrv_numa<V>::add(WSTM::WAtomic& at, V value) -> void {
+  setup_transaction_tracking(at);
+  this->setup_status_tracking(at);
+
+  if (delta_coalescing) {
+    this->deltas.add(at, value, [this](WSTM::WAtomic& at, V delta) {
+      this->add_to_chunks(at, delta);
+    });
+    return;
+  }
+
+  this->add_to_chunks(at, value);
+}
+
+template <std::integral V>
+auto mrv_numa<V>::add_to_chunks(WSTM::WAtomic& at, V value) -> void {
+  auto& group = *this->nodes[utils::current_numa_node()];
+  auto& chunks = *group.chunks.Get(at);
+  auto& chunk = chunks[utils::random_index(0, chunks.size() - 1)];
+
+  auto current_value = chunk.Get(at);
+
+  if (would_overflow(current_value, value)) {
+    throw exception(error::overflow);
+  }
+
+  chunk.Set(current_value + value, at);
+}
+
+template <std::integral V>
+auto mrv_numa<V>::sub(WSTM::WAtomic& at, V value) -> void {
+  setup_transaction_tracking(at);
+
+  // see `mrv_flex_vector::sub`
+  if (!this->apply_sub(at, value)) {
+    throw exception(error::insufficient_value);
+  }
+
+  this->setup_status_tracking(at);
+}
+
+template <std::integral V>
+auto mrv_numa<V>::try_sub(WSTM::WAtomic& at, V value) -> bool {
+  setup_transaction_tracking(at);
+
+  // no stock is not a failure here, the transaction still commits
+  this->setup_status_tracking(at);
+
+  return this->apply_sub(at, value);
+}
+
+template <std::integral V>
+auto mrv_numa<V>::track(WSTM::WAtomic& at) -> void {
+  setup_transaction_tracking(at);
+  this->setup_status_tracking(at);
+}
+
+template <std::integral V>
+auto mrv_numa<V>::apply_sub(WSTM::WAtomic& at, V value) -> bool {
+  if (delta_coalescing) {
+    return this->deltas.sub(at, value, [this](WSTM::WAtomic& at, V value) {
+      return this->sub_from_chunks(at, value);
+    });
+  }
+
+  return this->sub_from_chunks(at, value);
+}
+
+template <std::integral V>
+auto mrv_numa<V>::sub_from_chunks(WSTM::WAtomic& at, V value) -> bool {
+  auto count = this->nodes.size();
+  auto local = utils::current_numa_node();
+
+  // same two passes as `mrv_flex_vector::sub_from_chunks`, but the local group
+  // is read first and the other nodes are only read if it is not enough
+  std::array<WSTM::WVar<V>*, MAX_NODES> picked;
+  auto needed = 0u;
+  V available = 0;
+  // every chunk read, empty or not, for the skew signals
+  auto scanned = 0u;
+
+  for (auto n = 0u; n < count && available < value; ++n) {
+    auto& chunks = *this->nodes[(local + n) % count]->chunks.Get(at);
+    auto size = chunks.size();
+    auto start = utils::random_index(0, size - 1);
+
+    for (auto i = 0u; i < size && available < value; ++i) {
+      auto& chunk = chunks[(start + i) % size];
+      auto chunk_value = chunk.Get(at);
+      ++scanned;
+
+      if (chunk_value != 0) {
+        picked[needed++] = &chunk;
+        available += chunk_value;
+      }
+    }
+  }
+
+  this->record_skew(scanned, available >= value);
+
+  if (available < value) {
+    return false;
+  }
+
+  for (auto i = 0u; i < needed; ++i) {
+    auto& chunk = *picked[i];
+    auto current_chunk = chunk.Get(at);
+
+    if (current_chunk >= value) {
+      chunk.Set(current_chunk - value, at);
+      break;
+    }
+
+    value -= current_chunk;
+    chunk.Set(0, at);
+  }
+
+  return true;
+}
+
+template <std::integral V>
+auto mrv_numa<V>::resize(uint node, size_t size) -> void {
+  auto& group = *this->nodes[node];
+
+  // the transaction runs pinned to the node, so the new array is allocated and
+  // first touched there
+  utils::run_on_numa_node(node, [&]() {
+    WSTM::Atomically(
+        [&](WSTM::WAtomic& at) {
+          auto& current = *group.chunks.Get(at);
+          auto current_size = current.size();
+
+          std::vector<V> values(size, 0);
+          {
+            WSTM::WReadLockGuard<WSTM::WAtomic> lock(at);
+
+            for (auto i = 0u; i < current_size; ++i) {
+              auto value = current[i].Get(at);
+
+              if (i < size) {
+                values[i] = value;
+                continue;
+              }
+
+              auto& absorber = values[utils::random_index(0, size - 1)];
+              if (would_overflow(absorber, value)) {
+                throw exception(error::overflow);
+              }
+              absorber += value;
+            }
+          }
+
+          auto resized = std::make_shared<chunk_array_t<V>>();
+          resized->reserve(size);
+          for (auto value : values) {
+            resized->emplace_back(value);
+          }
+
+          group.chunks.Set(resized, at);
+        },
+        // see `mrv_array::resize`
+        WSTM::WMaxConflicts(RESIZE_MAX_CONFLICTS,
+                            WSTM::WConflictResolution::THROW));
+  });
+}
+
+template <std::integral V>
+auto mrv_numa<V>::add_nodes(uint node, double abort_rate) -> void {
+  auto size = this->nodes[node]->chunks.GetReadOnly()->size();
+  auto max_size = max_group_size();
+
+  if (size >= max_size) {
+    return;
+  }
+
+  auto to_add =
+      std::min((size_t)std::lround(1 + size * abort_rate), max_size - size);
+
+  if (to_add < 1) {
+    return;
+  }
+
+  try {
+    this->resize(node, size + to_add);
+  } catch (WSTM::WMaxConflictsException&) {
+    // it will be tried again in the next adjust phase
+    return;
+  } catch (exception& ex) {
+    // it will be tried again in the next adjust phase
+    return;
+  }
+
+#ifdef SPLITTABLE_DEBUG
+  std::cout << "increased id=" << this->id << " node=" << node << " w/abort "
+            << abort_rate << " | new size: " << size + to_add << "\n";
+#endif
+}
+
+template <std::integral V>
+auto mrv_numa<V>::remove_nodes(uint node, double abort_rate) -> void {
+  auto size = this->nodes[node]->chunks.GetReadOnly()->size();
+  auto to_remove = nodes_to_remove(size, abort_rate);
+
+  if (to_remove == 0) {
+    return;
+  }
+
+  try {
+    this->resize(node, size - to_remove);
+  } catch (WSTM::WMaxConflictsException&) {
+    // it will be tried again in the next adjust phase
+    return;
+  } catch (exception& ex) {
+    // it will be tried again in the next adjust phase
+    return;
+  }
+
+#ifdef SPLITTABLE_DEBUG
+  std::cout << "decreased id=" << this->id << " node=" << node << " w/abort "
+            << abort_rate << " | new size: " << size - to_remove << "\n";
+#endif
+}
+
+template <std::integral V>
+auto mrv_numa<V>::add_nodes(double abort_rate) -> void {
+  for (auto node = 0u; node < this->nodes.size(); ++node) {
+    this->add_nodes(node, abort_rate);
+  }
+}
+
+template <std::integral V>
+auto mrv_numa<V>::remove_nodes(double abort_rate) -> void {
+  for (auto node = 0u; node < this->nodes.size(); ++node) {
+    this->remove_nodes(node, abort_rate);
+  }
+}
+
+template <std::integral V>
+auto mrv_numa<V>::adjust() -> void {
+  for (auto node = 0u; node < this->nodes.size(); ++node) {
+    auto abort_rate = 0.0;
+
+    switch (adjust_decision(this->fetch_and_reset_status(node), abort_rate)) {
+      case adjust_t::grow:
+        this->add_nodes(node, abort_rate);
+        break;
+      case adjust_t::shrink:
+        this->remove_nodes(node, abort_rate);
+        break;
+      case adjust_t::keep:
+        break;
+    }
+  }
+}
+
+template <std::integral V>
+auto mrv_numa<V>::balance_nodes(WSTM::WAtomic& at) -> void {
+  auto count = this->nodes.size();
+
+  if (count < 2) {
+    throw exception();
+  }
+
+  std::vector<sum_t<V>> totals(count);
+  for (auto node = 0u; node < count; ++node) {
+    auto& chunks = *this->nodes[node]->chunks.Get(at);
+    totals[node] = snapshot_sum(snapshot<V>(at, chunks));
+  }
+
+  auto [poorest, richest] =
+      snapshot_minmax(std::span<const sum_t<V>>(totals));
+
+  if (totals[richest] - totals[poorest] <= MIN_BALANCE_DIFF) {
+    throw exception();
+  }
+
+  // only the largest chunk of the richest node gives value, so that a single
+  // remote chunk is written on each side
+  auto& from_chunks = *this->nodes[richest]->chunks.Get(at);
+  auto from_values = snapshot<V>(at, from_chunks);
+  auto& from = from_chunks[snapshot_minmax(from_values).second];
+
+  auto& to_chunks = *this->nodes[poorest]->chunks.Get(at);
+  auto& to = to_chunks[utils::random_index(0, to_chunks.size() - 1)];
+
+  auto from_value = from.Get(at);
+  auto to_value = to.Get(at);
+  V amount = std::min<sum_t<V>>((totals[richest] - totals[poorest]) / 2,
+                                static_cast<sum_t<V>>(from_value));
+
+  if (amount == 0 || would_overflow(to_value, amount)) {
+    throw exception();
+  }
+
+  from.Set(from_value - amount, at);
+  to.Set(to_value + amount, at);
+}
+
+template <std::integral V>
+auto mrv_numa<V>::balance() -> void {
+  // see `mrv_flex_vector::balance`
+  if (!balance_strategy) {
+    return;
+  }
+
+  // groups are balanced in their own transactions, so a busy node does not
+  // make the balance of the others retry
+  for (auto& group : this->nodes) {
+    try {
+      WSTM::Atomically([&](WSTM::WAtomic& at) {
+        balance_strategy(at, *group->chunks.Get(at));
+      });
+    } catch (exception& ex) {
+      // there is no problem if an exception is thrown, this will be tried
+      // again in the next balance phase
+    }
+  }
+
+  auto round = this->balance_rounds.fetch_add(1, std::memory_order_relaxed);
+  if ((round + 1) % CROSS_NODE_BALANCE_PERIOD != 0) {
+    return;
+  }
+
+  try {
+    WSTM::Atomically([&](WSTM::WAtomic& at) { this->balance_nodes(at); });
+  } catch (exception& ex) {
+    // same as above
+  }
+}
+
+}  // namespace splittable::mrv
@@ -2,36 +2,41 @@
 
 namespace splittable::pr {
 
-manager::manager() : total_phase_time(0), phase_iterations(0) {
+manager::manager()
+    : total_phase_time(0),
+      phase_iterations(0) {
   workers.emplace_back(
       // phase worker
       [this](std::stop_token stop_token) {
         while (!stop_token.stop_requested()) {
           std::this_thread::sleep_for(PHASE_INTERVAL);
 
-          values_type values;
-          {
-            // the structure is immutable, we only need the lock to fetch it
-            std::lock_guard<std::mutex> lock(this->values_mutex);
-            values = this->values;
-          }
-
           auto start = std::chrono::steady_clock::now();
 
-          std::for_each(
-              std::execution::par_unseq, values.begin(), values.end(),
-              [](std::pair<uint, std::shared_ptr<pr>> pair) {
-                auto counters = pair.second->fetch_and_reset_status();
-
-                double abort_rate = 0;
-                if (counters.commits > 0) {
-                  abort_rate = (double)counters.aborts /
-                               (double)(counters.aborts + counters.commits);
-                }
+          auto objects = this->lookup(this->active.take());
 
-                pair.second->try_transition(abort_rate, counters.waiting,
-                                            counters.aborts_for_no_stock);
-              });
+          {
+            auto skipped = this->run_on_pool(objects.size(), [&](size_t i) {
+              auto& pr = objects[i];
+              pr->clear_active();
+              auto counters = pr->fetch_and_reset_status();
+
+              double abort_rate = 0;
+              if (counters.commits > 0) {
+                abort_rate = (double)counters.aborts /
+                             (double)(counters.aborts + counters.commits);
+              }
+
+              pr->try_transition(abort_rate, counters.waiting,
+                                 counters.aborts_for_no_stock);
+            });
+
+            // their counters are left as they are, for the next phase
+            for (auto i : skipped) {
+              objects[i]->clear_active();
+              objects[i]->mark_active();
+            }
+          }
 
           auto end = std::chrono::steady_clock::now();
 
@@ -57,6 +62,12 @@ auto manager::register_pr(std::shared_ptr<pr> pr) -> void {
   std::cout << "registering " << pr->get_id() << "\n";
 #endif
 
+  // see `mrv::manager::register_mrv`
+  std::call_once(this->pool_created, [this]() {
+    std::lock_guard<std::mutex> lock(this->pool_mutex);
+    this->pool = std::make_unique<utils::worker_pool>(this->pool_options);
+  });
+
   values_type values;
   {
     std::lock_guard<std::mutex> lock(this->values_mutex);
@@ -80,6 +91,55 @@ auto manager::deregister_pr(std::shared_ptr<pr> pr) -> void {
   }
 }
 
+auto manager::configure_pool(utils::worker_pool_options options) -> void {
+  // see `mrv::manager::configure_pool`
+  std::lock_guard<std::mutex> lock(this->pool_mutex);
+  this->pool_options = std::move(options);
+
+  if (this->pool) {
+    this->pool = std::make_unique<utils::worker_pool>(this->pool_options);
+  }
+}
+
+auto manager::run_on_pool(size_t count,
+                          const std::function<void(size_t)>& task)
+    -> std::vector<size_t> {
+  // see `mrv::manager::run_on_pool`
+  std::lock_guard<std::mutex> lock(this->pool_mutex);
+
+  if (!this->pool) {
+    return {};
+  }
+
+  return this->pool->run(count, task);
+}
+
+auto manager::activate(std::atomic_bool& flag, uint id) -> void {
+  this->active.insert(flag, id);
+}
+
+auto manager::lookup(const std::vector<uint>& ids)
+    -> std::vector<std::shared_ptr<pr>> {
+  values_type values;
+  {
+    // the structure is immutable, we only need the lock to fetch it
+    std::lock_guard<std::mutex> lock(this->values_mutex);
+    values = this->values;
+  }
+
+  std::vector<std::shared_ptr<pr>> objects;
+  objects.reserve(ids.size());
+
+  for (auto id : ids) {
+    // it may have been deregistered since it was queued
+    if (auto pr = values.find(id)) {
+      objects.push_back(*pr);
+    }
+  }
+
+  return objects;
+}
+
 auto manager::get_avg_phase_interval() -> std::chrono::nanoseconds {
   {
     std::lock_guard<std::mutex> lock(this->phase_time_mutex);
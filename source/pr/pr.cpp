@@ -1,5 +1,7 @@
 #include "splittable/pr/pr.hpp"
 
+#include "splittable/pr/manager.hpp"
+
 namespace splittable::pr {
 
 std::atomic_uint pr::id_counter{0};
@@ -19,6 +21,14 @@ auto pr::register_thread() -> void {
   thread_id = thread_id_counter.fetch_add(1, std::memory_order_relaxed);
 }
 
+auto pr::mark_active() -> void {
+  manager::get_instance().activate(this->active, this->get_id());
+}
+
+auto pr::clear_active() -> void {
+  this->active.store(false, std::memory_order_relaxed);
+}
+
 // should only be called once, at the start of the program
 auto pr::set_num_threads(uint num) -> void { num_threads = num; }
 
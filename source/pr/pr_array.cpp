@@ -2,68 +2,95 @@
 
 namespace splittable::pr {
 
-pr_array::pr_array(uint value) : status_counters(0) {
+// explicit instantiations
+template class pr_array<uint32_t>;
+template class pr_array<uint64_t>;
+template class pr_array<int64_t>;
+
+template <std::integral V>
+pr_array<V>::pr_array(V value) {
   this->id = id_counter.fetch_add(1, std::memory_order_relaxed);
-  this->single_value = WSTM::WVar<uint>(value);
+  this->single_value = WSTM::WVar<V>(value);
   this->is_splitted = WSTM::WVar<bool>(false);
 }
 
-auto pr_array::new_instance(uint value) -> std::shared_ptr<pr_array> {
+template <std::integral V>
+auto pr_array<V>::new_instance(V value) -> std::shared_ptr<pr_array> {
   auto obj = std::make_shared<pr_array>(value);
   manager::get_instance().register_pr(obj);
   return obj;
 }
 
-auto pr_array::delete_instance(std::shared_ptr<pr_array> obj) -> void {
+template <std::integral V>
+auto pr_array<V>::delete_instance(std::shared_ptr<pr_array> obj) -> void {
   manager::get_instance().deregister_pr(obj);
 }
 
-auto pr_array::get_id() -> uint { return this->id; }
+template <std::integral V>
+auto pr_array<V>::get_id() -> uint {
+  return this->id;
+}
 
-auto pr_array::get_avg_adjust_interval() -> std::chrono::nanoseconds {
+template <std::integral V>
+auto pr_array<V>::get_avg_adjust_interval() -> std::chrono::nanoseconds {
   return std::chrono::nanoseconds(0);
 }
 
-auto pr_array::get_avg_balance_interval() -> std::chrono::nanoseconds {
+template <std::integral V>
+auto pr_array<V>::get_avg_balance_interval() -> std::chrono::nanoseconds {
   return std::chrono::nanoseconds(0);
 }
 
-auto pr_array::get_avg_phase_interval() -> std::chrono::nanoseconds {
+template <std::integral V>
+auto pr_array<V>::get_avg_phase_interval() -> std::chrono::nanoseconds {
   return manager::get_instance().get_avg_phase_interval();
 }
 
-auto pr_array::reset_global_stats() -> void {
+template <std::integral V>
+auto pr_array<V>::reset_global_stats() -> void {
   splittable::reset_global_stats();
   manager::get_instance().reset_global_stats();
 }
 
-auto pr_array::add_aborts(uint count) -> void {
-  this->status_counters.fetch_add(((ulong)count) << 48,
-                                  std::memory_order_relaxed);
+template <std::integral V>
+auto pr_array<V>::add_aborts(uint count) -> void {
+  this->status_counters.add(ABORTS_COUNTER, count);
 }
 
-auto pr_array::add_aborts_for_no_stock(uint count) -> void {
-  this->status_counters.fetch_add(((ulong)count) << 32,
-                                  std::memory_order_relaxed);
+template <std::integral V>
+auto pr_array<V>::add_aborts_for_no_stock(uint count) -> void {
+  this->status_counters.add(ABORTS_FOR_NO_STOCK_COUNTER, count);
+  // counted after the attempt queued the object, so a phase may have taken it
+  // in between; without queueing it again, the signal would wait for the next
+  // use of the object
+  this->mark_active();
 }
 
-auto pr_array::add_commits(uint count) -> void {
-  this->status_counters.fetch_add(((ulong)count) << 16,
-                                  std::memory_order_relaxed);
+template <std::integral V>
+auto pr_array<V>::add_attempts(uint count) -> void {
+  this->status_counters.add(ATTEMPTS_COUNTER, count);
+  this->mark_active();
 }
 
-auto pr_array::add_waiting(uint count) -> void {
-  this->status_counters.fetch_add((ulong)count, std::memory_order_relaxed);
+template <std::integral V>
+auto pr_array<V>::add_waiting(uint count) -> void {
+  this->status_counters.add(WAITING_COUNTER, count);
+  // see `add_aborts_for_no_stock`; here it matters even more, since the
+  // reader waits for a reconcile that only a phase that sees it can start
+  this->mark_active();
 }
 
-auto pr_array::fetch_and_reset_status() -> status {
-  auto counters =
-      this->status_counters.fetch_and(0u, std::memory_order_relaxed);
+template <std::integral V>
+auto pr_array<V>::fetch_and_reset_status() -> status {
+  auto counters = this->status_counters.fetch_and_reset();
+
+  auto waiting = counters[WAITING_COUNTER];
+  auto attempts = counters[ATTEMPTS_COUNTER];
+  auto aborts_for_no_stock = counters[ABORTS_FOR_NO_STOCK_COUNTER];
+  auto aborts = counters[ABORTS_COUNTER];
 
-  uint waiting = (counters & 0x000000000000FFFF);
-  uint commits = (counters & 0x00000000FFFF0000) >> 16;
-  uint aborts_for_no_stock = (counters & 0x0000FFFF00000000) >> 32;
-  uint aborts = (counters & 0xFFFF000000000000) >> 48;
+  // see `mrv_flex_vector::fetch_and_reset_status`
+  auto commits = attempts > aborts ? attempts - aborts : 0;
 
   return {.aborts = aborts,
           .aborts_for_no_stock = aborts_for_no_stock,
@@ -71,16 +98,20 @@ auto pr_array::fetch_and_reset_status() -> status {
           .waiting = waiting};
 }
 
-auto pr_array::setup_status_tracking(WSTM::WAtomic& at) -> void {
+template <std::integral V>
+auto pr_array<V>::setup_status_tracking(WSTM::WAtomic& at) -> void {
+  if (this->status_tracked.TestAndSet(at)) {
+    return;
+  }
+
+  // counting the attempt here avoids an `After` callback holding a weak_ptr,
+  // which does not fit in the small buffer of `std::function`
+  this->add_attempts(1);
   at.OnFail([this]() { this->add_aborts(1); });
-  at.After([ptr = weak_from_this()]() {
-    if (auto value = ptr.lock()) {
-      value->add_commits(1u);
-    }
-  });
 }
 
-auto pr_array::read(WSTM::WAtomic& at) -> uint {
+template <std::integral V>
+auto pr_array<V>::read(WSTM::WAtomic& at) -> V {
   setup_transaction_tracking(at);
   setup_status_tracking(at);
 
@@ -89,28 +120,102 @@ auto pr_array::read(WSTM::WAtomic& at) -> uint {
     WSTM::Retry(at);
   }
 
+  if (delta_coalescing) {
+    return this->single_value.Get(at) + this->deltas.get(at);
+  }
+
   return this->single_value.Get(at);
 }
 
-auto pr_array::add(WSTM::WAtomic& at, uint to_add) -> void {
+template <std::integral V>
+auto pr_array<V>::inconsistent_read(WSTM::WInconsistent& inc) -> V {
+  // unlike `read`, this does not wait for the value to be reconciled: while
+  // splitted, the chunks are summed directly
+  if (!this->is_splitted.GetInconsistent(inc)) {
+    return this->single_value.GetInconsistent(inc);
+  }
+
+  auto splitted = this->splitted_value.GetInconsistent(inc);
+
+  V sum = 0;
+  {
+    WSTM::WReadLockGuard<WSTM::WInconsistent> lock(inc);
+
+    for (auto& chunk : *splitted) {
+      sum += chunk.GetInconsistent(inc);
+    }
+  }
+
+  return sum;
+}
+
+template <std::integral V>
+auto pr_array<V>::add(WSTM::WAtomic& at, V to_add) -> void {
+  setup_transaction_tracking(at);
+  setup_status_tracking(at);
+
+  if (delta_coalescing) {
+    this->deltas.add(at, to_add, [this](WSTM::WAtomic& at, V delta) {
+      this->add_to_value(at, delta);
+    });
+    return;
+  }
+
+  this->add_to_value(at, to_add);
+}
+
+template <std::integral V>
+auto pr_array<V>::sub(WSTM::WAtomic& at, V to_sub) -> void {
+  if (!this->try_sub(at, to_sub)) {
+    throw exception(error::insufficient_value);
+  }
+}
+
+template <std::integral V>
+auto pr_array<V>::try_sub(WSTM::WAtomic& at, V to_sub) -> bool {
   setup_transaction_tracking(at);
   setup_status_tracking(at);
 
+  if (delta_coalescing) {
+    return this->deltas.sub(at, to_sub, [this](WSTM::WAtomic& at, V to_sub) {
+      return this->sub_from_value(at, to_sub);
+    });
+  }
+
+  return this->sub_from_value(at, to_sub);
+}
+
+template <std::integral V>
+auto pr_array<V>::track(WSTM::WAtomic& at) -> void {
+  setup_transaction_tracking(at);
+  setup_status_tracking(at);
+}
+
+template <std::integral V>
+auto pr_array<V>::add_to_value(WSTM::WAtomic& at, V to_add) -> void {
   if (this->is_splitted.Get(at)) {
     auto splitted = this->splitted_value.Get(at);
     auto chunk = &splitted->at(this->thread_id);
     auto current_chunk = chunk->Get(at);
+
+    if (would_overflow(current_chunk, to_add)) {
+      throw exception(error::overflow);
+    }
+
     chunk->Set(current_chunk + to_add, at);
   } else {
     auto current_value = this->single_value.Get(at);
+
+    if (would_overflow(current_value, to_add)) {
+      throw exception(error::overflow);
+    }
+
     this->single_value.Set(current_value + to_add, at);
   }
 }
 
-auto pr_array::sub(WSTM::WAtomic& at, uint to_sub) -> void {
-  setup_transaction_tracking(at);
-  setup_status_tracking(at);
-
+template <std::integral V>
+auto pr_array<V>::sub_from_value(WSTM::WAtomic& at, V to_sub) -> bool {
   if (this->is_splitted.Get(at)) {
     auto splitted = this->splitted_value.Get(at);
     auto chunk = &splitted->at(this->thread_id);
@@ -118,8 +223,7 @@ auto pr_array::sub(WSTM::WAtomic& at, uint to_sub) -> void {
 
     if (current_chunk < to_sub) {
       this->add_aborts_for_no_stock(1);
-      // TODO: change this to a better exception
-      throw std::exception();
+      return false;
     }
 
     chunk->Set(current_chunk - to_sub, at);
@@ -128,19 +232,21 @@ auto pr_array::sub(WSTM::WAtomic& at, uint to_sub) -> void {
 
     if (current_value < to_sub) {
       this->add_aborts_for_no_stock(1);
-      // TODO: change this to a better exception
-      throw std::exception();
+      return false;
     }
 
     this->single_value.Set(current_value - to_sub, at);
   }
+
+  return true;
 }
 
-auto pr_array::try_transition(double abort_rate, uint waiting,
-                              uint aborts_for_no_stock) -> void {
+template <std::integral V>
+auto pr_array<V>::try_transition(double abort_rate, uint waiting,
+                                 uint aborts_for_no_stock) -> void {
   try {
     WSTM::Atomically(
-        [ptr = weak_from_this(), waiting, aborts_for_no_stock,
+        [ptr = this->weak_from_this(), waiting, aborts_for_no_stock,
          abort_rate](WSTM::WAtomic& at) {
           if (auto value = ptr.lock()) {
             auto is_splitted = value->is_splitted.Get(at);
@@ -164,7 +270,8 @@ auto pr_array::try_transition(double abort_rate, uint waiting,
   }
 }
 
-auto pr_array::split(WSTM::WAtomic& at) -> void {
+template <std::integral V>
+auto pr_array<V>::split(WSTM::WAtomic& at) -> void {
   if (this->is_splitted.Get(at)) {
     throw std::exception();
   }
@@ -189,14 +296,15 @@ auto pr_array::split(WSTM::WAtomic& at) -> void {
 #endif
 }
 
-auto pr_array::reconcile(WSTM::WAtomic& at) -> void {
+template <std::integral V>
+auto pr_array<V>::reconcile(WSTM::WAtomic& at) -> void {
   if (!this->is_splitted.Get(at)) {
     throw std::exception();
   }
 
   auto splitted = this->splitted_value.Get(at);
 
-  auto new_value = 0u;
+  V new_value = 0;
 
   {
     // this will improve performance since we are reading a lot of variables in
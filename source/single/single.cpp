@@ -1,56 +1,127 @@
 #include "splittable/single/single.hpp"
 
 namespace splittable::single {
-single::single(uint value) : value(value) {}
 
-auto single::thread_init() -> void {}
+// explicit instantiations
+template class single<uint32_t>;
+template class single<uint64_t>;
+template class single<int64_t>;
 
-auto single::global_init(uint) -> void {}
+template <std::integral V>
+single<V>::single(V value) : value(value) {}
 
-auto single::new_instance(uint value) -> std::shared_ptr<single> {
+template <std::integral V>
+auto single<V>::thread_init() -> void {}
+
+template <std::integral V>
+auto single<V>::global_init(uint) -> void {}
+
+template <std::integral V>
+auto single<V>::new_instance(V value) -> std::shared_ptr<single> {
   return std::make_shared<single>(value);
 }
 
-auto single::delete_instance(std::shared_ptr<single>) -> void {}
+template <std::integral V>
+auto single<V>::delete_instance(std::shared_ptr<single>) -> void {}
 
-auto single::get_avg_adjust_interval() -> std::chrono::nanoseconds {
+template <std::integral V>
+auto single<V>::get_avg_adjust_interval() -> std::chrono::nanoseconds {
   return std::chrono::nanoseconds(0);
 }
 
-auto single::get_avg_balance_interval() -> std::chrono::nanoseconds {
+template <std::integral V>
+auto single<V>::get_avg_balance_interval() -> std::chrono::nanoseconds {
   return std::chrono::nanoseconds(0);
 }
 
-auto single::get_avg_phase_interval() -> std::chrono::nanoseconds {
+template <std::integral V>
+auto single<V>::get_avg_phase_interval() -> std::chrono::nanoseconds {
   return std::chrono::nanoseconds(0);
 }
 
-auto single::reset_global_stats() -> void { splittable::reset_global_stats(); }
+template <std::integral V>
+auto single<V>::reset_global_stats() -> void {
+  splittable::reset_global_stats();
+}
 
-auto single::read(WSTM::WAtomic& at) -> uint {
+template <std::integral V>
+auto single<V>::read(WSTM::WAtomic& at) -> V {
   setup_transaction_tracking(at);
+
+  if (delta_coalescing) {
+    return this->value.Get(at) + this->deltas.get(at);
+  }
+
   return this->value.Get(at);
 }
 
-auto single::add(WSTM::WAtomic& at, uint value) -> void {
+template <std::integral V>
+auto single<V>::inconsistent_read(WSTM::WInconsistent& inc) -> V {
+  return this->value.GetInconsistent(inc);
+}
+
+template <std::integral V>
+auto single<V>::add(WSTM::WAtomic& at, V value) -> void {
+  setup_transaction_tracking(at);
+
+  if (delta_coalescing) {
+    this->deltas.add(at, value, [this](WSTM::WAtomic& at, V delta) {
+      this->add_to_value(at, delta);
+    });
+    return;
+  }
+
+  this->add_to_value(at, value);
+}
+
+template <std::integral V>
+auto single<V>::sub(WSTM::WAtomic& at, V value) -> void {
+  if (!this->try_sub(at, value)) {
+    throw exception(error::insufficient_value);
+  }
+}
+
+template <std::integral V>
+auto single<V>::try_sub(WSTM::WAtomic& at, V value) -> bool {
   setup_transaction_tracking(at);
 
+  if (delta_coalescing) {
+    return this->deltas.sub(at, value, [this](WSTM::WAtomic& at, V value) {
+      return this->sub_from_value(at, value);
+    });
+  }
+
+  return this->sub_from_value(at, value);
+}
+
+template <std::integral V>
+auto single<V>::track(WSTM::WAtomic& at) -> void {
+  setup_transaction_tracking(at);
+}
+
+template <std::integral V>
+auto single<V>::add_to_value(WSTM::WAtomic& at, V value) -> void {
   auto current = this->value.Get(at);
+
+  if (would_overflow(current, value)) {
+    throw exception(error::overflow);
+  }
+
   current += value;
   this->value.Set(current, at);
 }
 
-auto single::sub(WSTM::WAtomic& at, uint value) -> void {
-  setup_transaction_tracking(at);
-
+template <std::integral V>
+auto single<V>::sub_from_value(WSTM::WAtomic& at, V value) -> bool {
   auto current = this->value.Get(at);
 
   if (current < value) {
-    // TODO: change this to a better exception
-    throw std::exception();
+    return false;
   }
 
   current -= value;
   this->value.Set(current, at);
+  return true;
 }
+
 }  // namespace splittable::single
@@ -2,21 +2,53 @@
 
 namespace splittable {
 
-std::atomic_uint64_t splittable::total_aborts(0);
-std::atomic_uint64_t splittable::total_commits(0);
+std::array<splittable::stats_shard, splittable::MAX_STATS_SHARDS>
+    splittable::stats_shards{};
+std::atomic_uint splittable::stats_shard_counter(0);
+thread_local uint splittable::stats_shard_index(
+    stats_shard_counter.fetch_add(1, std::memory_order_relaxed) %
+    MAX_STATS_SHARDS);
+bool splittable::delta_coalescing(false);
+WSTM::WTransactionLocalFlag splittable::transaction_tracked;
 
 auto splittable::setup_transaction_tracking(WSTM::WAtomic& at) -> void {
-  at.OnFail([]() { total_aborts.fetch_add(1, std::memory_order_relaxed); });
-  at.After([]() { total_commits.fetch_add(1, std::memory_order_relaxed); });
+  if (transaction_tracked.TestAndSet(at)) {
+    return;
+  }
+
+  // both run in the thread that ran the transaction, so they hit its shard
+  at.OnFail([]() {
+    local_stats_shard().aborts.fetch_add(1, std::memory_order_relaxed);
+  });
+  at.After([]() {
+    local_stats_shard().commits.fetch_add(1, std::memory_order_relaxed);
+  });
+}
+
+auto splittable::local_stats_shard() -> stats_shard& {
+  return stats_shards[stats_shard_index];
+}
+
+auto splittable::set_delta_coalescing(bool enabled) -> void {
+  delta_coalescing = enabled;
 }
 
 auto splittable::reset_global_stats() -> void {
-  total_commits.store(0);
-  total_aborts.store(0);
+  for (auto& shard : stats_shards) {
+    shard.commits.store(0);
+    shard.aborts.store(0);
+  }
 }
 
 auto splittable::get_global_stats() -> status {
-  return status{.aborts = total_aborts.load(), .commits = total_commits.load()};
+  status total{.aborts = 0, .commits = 0};
+
+  for (auto& shard : stats_shards) {
+    total.aborts += shard.aborts.load();
+    total.commits += shard.commits.load();
+  }
+
+  return total;
 }
 
 }  // namespace splittable
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "splittable/utils/epoch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace splittable::utils {
+
+namespace {
+
+const uint64_t INACTIVE = std::numeric_limits<uint64_t>::max();
+
+struct alignas(std::hardware_destructive_interference_size) thread_record {
+  // epoch seen when the outermost guard was entered, or `INACTIVE`
+  std::atomic_uint64_t epoch{INACTIVE};
+  // only touched by the owning thread
+  uint depth = 0;
+};
+
+struct retired_t {
+  uint64_t epoch;
+  void* ptr;
+  void (*deleter)(void*);
+};
+
+std::atomic_uint64_t global_epoch(0);
+
+std::mutex records_mutex;
+std::vector<thread_record*> records;
+
+std::mutex retired_mutex;
+std::vector<retired_t> retired;
+
+// registers the thread's record on its first guard and removes it when the
+// thread exits, so the reclaimer never waits on a dead thread
+struct record_owner {
+  thread_record* record;
+
+  record_owner() : record(new thread_record()) {
+    std::lock_guard<std::mutex> lock(records_mutex);
+    records.push_back(this->record);
+  }
+
+  ~record_owner() {
+    {
+      std::lock_guard<std::mutex> lock(records_mutex);
+      std::erase(records, this->record);
+    }
+    delete this->record;
+  }
+};
+
+auto local_record() -> thread_record& {
+  thread_local record_owner owner;
+  return *owner.record;
+}
+
+}  // namespace
+
+epoch_guard::epoch_guard() {
+  auto& record = local_record();
+
+  if (record.depth++ == 0) {
+    record.epoch.store(global_epoch.load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+    // the epoch must be visible before any protected pointer is loaded
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+}
+
+epoch_guard::~epoch_guard() {
+  auto& record = local_record();
+
+  if (--record.depth == 0) {
+    record.epoch.store(INACTIVE, std::memory_order_release);
+  }
+}
+
+auto epoch_retire(void* ptr, void (*deleter)(void*)) -> void {
+  // threads that entered before this increment may still hold `ptr`; the ones
+  // that enter after it can only see whatever replaced it
+  auto epoch = global_epoch.fetch_add(1, std::memory_order_seq_cst);
+
+  auto oldest = INACTIVE;
+  {
+    std::lock_guard<std::mutex> lock(records_mutex);
+    for (auto record : records) {
+      oldest = std::min(oldest, record->epoch.load(std::memory_order_seq_cst));
+    }
+  }
+
+  std::vector<retired_t> to_free;
+  {
+    std::lock_guard<std::mutex> lock(retired_mutex);
+    retired.push_back({.epoch = epoch, .ptr = ptr, .deleter = deleter});
+
+    std::erase_if(retired, [&](const retired_t& entry) {
+      if (entry.epoch >= oldest) {
+        return false;
+      }
+      to_free.push_back(entry);
+      return true;
+    });
+  }
+
+  for (auto& entry : to_free) {
+    entry.deleter(entry.ptr);
+  }
+}
+
+auto epoch_synchronize() -> void {
+  // guards entered after this increment see the new epoch, so only the ones
+  // with an older epoch have to be waited on
+  auto epoch = global_epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+
+  // the lock keeps exiting threads from freeing their record while it is
+  // checked; they are not in a guard, so they never hold up the wait
+  std::lock_guard<std::mutex> lock(records_mutex);
+
+  for (auto record : records) {
+    while (record->epoch.load(std::memory_order_seq_cst) < epoch) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+}  // namespace splittable::utils
@@ -0,0 +1,113 @@
+#include "splittable/utils/numa.hpp"
+
+#include <sched.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace splittable::utils {
+
+namespace {
+
+const std::string NODES_PATH = "/sys/devices/system/node/";
+
+// parses the "0-3,8-11" lists used by sysfs
+auto parse_list(std::istream& input) -> std::vector<uint> {
+  std::vector<uint> values;
+
+  std::string range;
+  while (std::getline(input, range, ',')) {
+    uint first = 0;
+    uint last = 0;
+    char dash = 0;
+
+    std::istringstream stream(range);
+    if (!(stream >> first)) {
+      continue;
+    }
+    last = stream >> dash >> last ? last : first;
+
+    for (auto value = first; value <= last; ++value) {
+      values.push_back(value);
+    }
+  }
+
+  return values;
+}
+
+// an unreadable file gives an empty list
+auto read_list(const std::string& path) -> std::vector<uint> {
+  std::ifstream file(path);
+  return parse_list(file);
+}
+
+}  // namespace
+
+auto parse_cpu_list(const std::string& list) -> std::vector<uint> {
+  std::istringstream input(list);
+  return parse_list(input);
+}
+
+auto numa_node_count() -> uint {
+  static const uint count = [] {
+    auto nodes = read_list(NODES_PATH + "online");
+    return nodes.empty() ? 1u
+                         : *std::max_element(nodes.begin(), nodes.end()) + 1;
+  }();
+
+  return count;
+}
+
+auto current_numa_node() -> uint {
+  uint cpu = 0;
+  uint node = 0;
+
+  if (getcpu(&cpu, &node) != 0) {
+    return 0;
+  }
+
+  return node % numa_node_count();
+}
+
+auto run_on_numa_node(uint node, const std::function<void()>& fn) -> void {
+  if (numa_node_count() == 1) {
+    fn();
+    return;
+  }
+
+  auto cpus =
+      read_list(NODES_PATH + "node" + std::to_string(node) + "/cpulist");
+
+  cpu_set_t previous;
+  if (cpus.empty() || sched_getaffinity(0, sizeof(previous), &previous) != 0) {
+    // no placement then, but the work still has to be done
+    fn();
+    return;
+  }
+
+  cpu_set_t pinned;
+  CPU_ZERO(&pinned);
+  for (auto cpu : cpus) {
+    CPU_SET(cpu, &pinned);
+  }
+
+  auto moved = sched_setaffinity(0, sizeof(pinned), &pinned) == 0;
+
+  try {
+    fn();
+  } catch (...) {
+    if (moved) {
+      sched_setaffinity(0, sizeof(previous), &previous);
+    }
+    throw;
+  }
+
+  if (moved) {
+    sched_setaffinity(0, sizeof(previous), &previous);
+  }
+}
+
+}  // namespace splittable::utils
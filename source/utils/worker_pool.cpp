@@ -0,0 +1,161 @@
+#include "splittable/utils/worker_pool.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+namespace splittable::utils {
+
+namespace {
+
+// CPU time of the calling thread, so the budget does not count the time the
+// workers spend waiting or preempted
+auto thread_cpu_time() -> std::chrono::nanoseconds {
+  timespec time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return std::chrono::seconds(time.tv_sec) +
+         std::chrono::nanoseconds(time.tv_nsec);
+}
+
+}  // namespace
+
+worker_pool::worker_pool(worker_pool_options options)
+    : options(std::move(options)),
+      ranges(std::max<size_t>(this->options.threads, 1)) {
+  for (auto i = 0u; i < this->options.threads; ++i) {
+    this->threads.emplace_back([this, i](std::stop_token stop_token) {
+      this->worker_main(stop_token, i);
+    });
+  }
+}
+
+worker_pool::~worker_pool() {
+  // the threads have to stop before the members they use are destroyed
+  for (auto& thread : this->threads) {
+    thread.request_stop();
+  }
+  this->threads.clear();
+}
+
+auto worker_pool::worker_main(std::stop_token stop_token, size_t index)
+    -> void {
+  if (!this->options.cpus.empty()) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(this->options.cpus[index % this->options.cpus.size()], &cpus);
+
+    // an invalid CPU leaves the worker unpinned, which is still correct
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  }
+
+  uint64_t seen = 0;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->start_condition.wait(lock, stop_token, [&]() {
+        return this->generation != seen;
+      });
+
+      if (stop_token.stop_requested()) {
+        return;
+      }
+
+      seen = this->generation;
+    }
+
+    this->work(index);
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      if (--this->running == 0) {
+        this->done_condition.notify_all();
+      }
+    }
+  }
+}
+
+auto worker_pool::claim(size_t index, size_t count) -> size_t {
+  auto size = this->ranges.size();
+
+  for (auto i = 0u; i < size; ++i) {
+    auto& range = this->ranges[(index + i) % size];
+
+    // the load keeps idle workers from writing to the cursors of ranges that
+    // are already done
+    if (range.next.load(std::memory_order_relaxed) >= range.end) {
+      continue;
+    }
+
+    auto claimed = range.next.fetch_add(1, std::memory_order_relaxed);
+    if (claimed < range.end) {
+      return range.first + claimed * size;
+    }
+  }
+
+  return count;
+}
+
+auto worker_pool::work(size_t index) -> void {
+  auto limited = this->options.cpu_budget.count() > 0;
+  auto count = this->count;
+  auto last = thread_cpu_time();
+
+  while (!limited || this->cpu_left.load(std::memory_order_relaxed) > 0) {
+    auto item = this->claim(index, count);
+    if (item == count) {
+      return;
+    }
+
+    (*this->task)(item);
+
+    if (limited) {
+      auto now = thread_cpu_time();
+      this->cpu_left.fetch_sub((now - last).count(), std::memory_order_relaxed);
+      last = now;
+    }
+  }
+}
+
+auto worker_pool::run(size_t count, const std::function<void(size_t)>& task)
+    -> std::vector<size_t> {
+  auto size = this->ranges.size();
+
+  for (auto i = 0u; i < size; ++i) {
+    this->ranges[i].first = i;
+    this->ranges[i].next.store(0, std::memory_order_relaxed);
+    this->ranges[i].end = i < count ? (count - i + size - 1) / size : 0;
+  }
+
+  this->count = count;
+
+  this->task = &task;
+  this->cpu_left.store(this->options.cpu_budget.count(),
+                       std::memory_order_relaxed);
+
+  if (this->threads.empty()) {
+    this->work(0);
+  } else {
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    this->running = this->threads.size();
+    ++this->generation;
+    this->start_condition.notify_all();
+
+    this->done_condition.wait(lock, [this]() { return this->running == 0; });
+  }
+
+  std::vector<size_t> skipped;
+
+  for (auto& range : this->ranges) {
+    for (auto i = std::min(range.next.load(std::memory_order_relaxed),
+                           range.end);
+         i < range.end; ++i) {
+      skipped.push_back(range.first + i * size);
+    }
+  }
+
+  return skipped;
+}
+
+}  // namespace splittable::utils